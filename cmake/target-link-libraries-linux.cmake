@@ -4,10 +4,12 @@ target_link_libraries(
         glfw3
         pthread
         dl
+        EGL
         X11
         freeimage
         opencv_core
         opencv_imgproc
         opencv_imgcodecs
+        opencv_videoio
         opencv_highgui
 )
\ No newline at end of file
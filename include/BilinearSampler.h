@@ -0,0 +1,46 @@
+#pragma once
+
+#include "_Common.h"
+
+// It gathers and blends 8-bit BGR taps with fixed-point weights.
+// SSE4.1 blends the three channels of two taps at once per pixel and AVX2 does that for two pixels at once.
+// The scalar path is used when neither is supported, and all paths produce the same result bit by bit.
+class BilinearSampler
+{
+public:
+   enum class INSTRUCTION_SET { SCALAR = 0, SSE41, AVX2 };
+
+   static constexpr int WeightBits = 8;
+   static constexpr int WeightOne = 1 << WeightBits;
+
+   struct RemapEntry
+   {
+      int Offset; // byte offset of the top-left tap in the continuous source image
+      ushort Weights[4]; // left, right, top and bottom weights which sum up to WeightOne in each direction
+   };
+
+   struct RemapTable
+   {
+      cv::Size SourceSize;
+      cv::Size ConvertedSize;
+      std::vector<RemapEntry> Entries; // the pixels which are not covered by the source have zero weights
+   };
+
+   BilinearSampler() = default;
+   ~BilinearSampler() = default;
+
+   static void getRemapEntry(RemapEntry& entry, const cv::Point2d& point, const cv::Size& source_size);
+   static void getInvalidRemapEntry(RemapEntry& entry);
+   static void remap(cv::Mat& converted, const cv::Mat& source, const RemapTable& table, const cv::Range& row_range);
+   [[nodiscard]] static INSTRUCTION_SET getInstructionSet() { return getSelectedInstructionSet(); }
+   // It is for the comparison among the paths. The instruction set is lowered if the CPU does not support it.
+   static void setInstructionSet(INSTRUCTION_SET instruction_set);
+
+private:
+   [[nodiscard]] static INSTRUCTION_SET getSupportedInstructionSet();
+   [[nodiscard]] static INSTRUCTION_SET& getSelectedInstructionSet();
+
+   static void remapScalar(uchar* converted_ptr, const uchar* source, int source_step, const RemapEntry* entries, int num);
+   static void remapSSE41(uchar* converted_ptr, const uchar* source, int source_step, const RemapEntry* entries, int num);
+   static void remapAVX2(uchar* converted_ptr, const uchar* source, int source_step, const RemapEntry* entries, int num);
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "_Common.h"
+
+// A blocking FIFO with a fixed capacity which connects two pipeline stages.
+// push() waits while the queue is full and pop() waits while it is empty, so a fast stage can run ahead of a slow one
+// by at most the capacity. After close(), push() fails and pop() drains the remaining items and then fails.
+template<typename T>
+class BoundedQueue
+{
+public:
+   explicit BoundedQueue(size_t capacity) :
+      Closed( false ), Capacity( std::max( capacity, static_cast<size_t>(1) ) ), MaxOccupancy( 0 ),
+      OccupancySum( 0 ), OccupancySampleNum( 0 ) {}
+   ~BoundedQueue() = default;
+
+   bool push(T item)
+   {
+      std::unique_lock<std::mutex> lock(Mutex);
+      NotFull.wait( lock, [this] { return Closed || Items.size() < Capacity; } );
+      if (Closed) return false;
+
+      Items.emplace_back( std::move( item ) );
+      sampleOccupancy();
+      NotEmpty.notify_one();
+      return true;
+   }
+
+   bool pop(T& item)
+   {
+      std::unique_lock<std::mutex> lock(Mutex);
+      NotEmpty.wait( lock, [this] { return Closed || !Items.empty(); } );
+      if (Items.empty()) return false;
+
+      item = std::move( Items.front() );
+      Items.pop_front();
+      sampleOccupancy();
+      NotFull.notify_one();
+      return true;
+   }
+
+   void close()
+   {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Closed = true;
+      NotFull.notify_all();
+      NotEmpty.notify_all();
+   }
+
+   [[nodiscard]] size_t getCapacity() const { return Capacity; }
+   [[nodiscard]] size_t getMaxOccupancy() const
+   {
+      std::lock_guard<std::mutex> lock(Mutex);
+      return MaxOccupancy;
+   }
+   [[nodiscard]] double getAverageOccupancy() const
+   {
+      std::lock_guard<std::mutex> lock(Mutex);
+      return OccupancySampleNum == 0 ? 0.0 : static_cast<double>(OccupancySum) / static_cast<double>(OccupancySampleNum);
+   }
+
+private:
+   bool Closed;
+   size_t Capacity;
+   size_t MaxOccupancy;
+   size_t OccupancySum;
+   size_t OccupancySampleNum;
+   std::deque<T> Items;
+   mutable std::mutex Mutex;
+   std::condition_variable NotFull;
+   std::condition_variable NotEmpty;
+
+   void sampleOccupancy()
+   {
+      MaxOccupancy = std::max( MaxOccupancy, Items.size() );
+      OccupancySum += Items.size();
+      OccupancySampleNum++;
+   }
+};
\ No newline at end of file
@@ -17,6 +17,8 @@ public:
 
    [[nodiscard]] bool getMovingState() const { return IsMoving; }
    [[nodiscard]] glm::vec3 getCameraPosition() const { return CamPos; }
+   [[nodiscard]] glm::quat getOrientation() const { return glm::quat_cast( glm::mat3(ViewMatrix) ); }
+   [[nodiscard]] float getFieldOfView() const { return FOV; }
    [[nodiscard]] const glm::mat4& getViewMatrix() const { return ViewMatrix; }
    [[nodiscard]] const glm::mat4& getProjectionMatrix() const { return ProjectionMatrix; }
    void setMovingState(bool is_moving) { IsMoving = is_moving; }
@@ -33,6 +35,9 @@ public:
    void zoomIn();
    void zoomOut();
    void resetCamera();
+   void setPose(const glm::vec3& cam_position, const glm::vec3& view_reference_position, const glm::vec3& view_up_vector);
+   // The orientation is the rotation of the view matrix, as getOrientation() returns.
+   void setState(const glm::vec3& cam_position, const glm::quat& orientation, float fov);
    void updateWindowSize(int width, int height);
 
 private:
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Camera.h"
+
+// It records the camera state of every frame and the keys which change the scene, stamped with the seconds since the
+// recording started, so that the same path can be replayed at a fixed step on any machine.
+// Each line of the file is one of
+//    scene <cow or tiger> <reflection mode> <lighting mode> <light on> <activated light> <tiger keyframe> <tiger angle>
+//    <time> camera <position (x y z)> <orientation of the view (w x y z)> <field of view in degrees>
+//    <time> key <GLFW key code>
+// and the camera lines should be in the order of their times. The empty lines and the lines starting with # are skipped.
+class CameraPath
+{
+public:
+   struct SceneState
+   {
+      bool DrawMovingObject;
+      int ReflectionMode;
+      int LightingMode;
+      bool LightOn;
+      int ActivatedLightIndex;
+      int TigerIndex;
+      int TigerRotationAngle;
+
+      SceneState() :
+         DrawMovingObject( false ), ReflectionMode( 0 ), LightingMode( 0 ), LightOn( false ), ActivatedLightIndex( 0 ),
+         TigerIndex( 0 ), TigerRotationAngle( 0 ) {}
+   };
+
+   struct CameraState
+   {
+      double Time;
+      glm::vec3 Position;
+      glm::quat Orientation;
+      float FOV;
+
+      CameraState() : Time( 0.0 ), Position( 0.0f ), Orientation( 1.0f, 0.0f, 0.0f, 0.0f ), FOV( 30.0f ) {}
+   };
+
+   struct KeyEvent
+   {
+      double Time;
+      int Key;
+   };
+
+   CameraPath() = default;
+   ~CameraPath() = default;
+
+   void begin(const SceneState& scene);
+   void addCameraState(double time, const CameraGL& camera);
+   void addKey(double time, int key);
+   [[nodiscard]] bool save(const std::string& file_path) const;
+   [[nodiscard]] bool load(const std::string& file_path);
+   [[nodiscard]] const SceneState& getSceneState() const { return Scene; }
+   [[nodiscard]] const std::vector<KeyEvent>& getKeyEvents() const { return KeyEvents; }
+   [[nodiscard]] double getDuration() const { return CameraStates.empty() ? 0.0 : CameraStates.back().Time; }
+   // It interpolates the recorded states linearly, and the orientations spherically.
+   [[nodiscard]] CameraState getCameraState(double time) const;
+
+private:
+   SceneState Scene;
+   std::vector<CameraState> CameraStates;
+   std::vector<KeyEvent> KeyEvents;
+};
\ No newline at end of file
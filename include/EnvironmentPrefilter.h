@@ -0,0 +1,76 @@
+#pragma once
+
+#include "LongitudeLatitudeMapping.h"
+
+// It prefilters a cube map from LongitudeLatitudeMapping::convertToCubemap() for the image-based lighting.
+// The specular chain has one mip level per roughness, so a material of any roughness reflects with one textureLod(),
+// and the irradiance map keeps the cosine-weighted radiance around each normal for the diffuse lighting.
+// Both are written to a cache keyed by the hash of the cube map, so the same environment is filtered only once.
+class EnvironmentPrefilter
+{
+public:
+   explicit EnvironmentPrefilter(int sample_num = 128, int min_face_size = 16, int irradiance_face_size = 32);
+   ~EnvironmentPrefilter() = default;
+
+   // cubemap has the six faces in CV_8UC3 stacked from top to bottom in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face.
+   // specular[level] is filtered with the GGX lobe of roughness level / (specular.size() - 1) and its faces are halved
+   // at each level down to min_face_size, so it can be uploaded as the mip chain. Both results are in CV_32FC3 of
+   // [0, 1] with the faces stacked as cubemap. Every output row is independent, so the rows are split across
+   // thread_num threads. (0 means all cores.) It returns true if the results are loaded from the cache.
+   bool prefilter(std::vector<cv::Mat>& specular, cv::Mat& irradiance, const cv::Mat& cubemap, int thread_num = 1);
+
+private:
+   struct Header
+   {
+      char Magic[4];
+      uint32_t Version;
+      uint32_t FaceSize;
+      uint32_t LevelNum;
+      uint32_t SampleNum;
+      uint32_t IrradianceFaceSize;
+      uint64_t SourceHash;
+   };
+
+   struct LobeSample
+   {
+      cv::Vec3f Direction; // in the tangent space whose z-axis is the normal
+      float Weight;
+      float Lod;
+   };
+
+   inline static constexpr char CacheMagic[4] = { 'E', 'M', 'P', 'F' };
+   inline static constexpr uint32_t CacheVersion = 1;
+   inline static constexpr int IrradianceSourceFaceSize = 32;
+
+   int SampleNum;
+   int MinFaceSize;
+   int IrradianceFaceSize;
+
+   [[nodiscard]] static uint64_t getHash(const cv::Mat& cubemap);
+   [[nodiscard]] static std::string getCachePath(uint64_t source_hash);
+   [[nodiscard]] static bool readCache(
+      std::vector<cv::Mat>& specular,
+      cv::Mat& irradiance,
+      const std::string& cache_path,
+      const Header& header
+   );
+   [[nodiscard]] static bool writeCache(
+      const std::string& cache_path,
+      const Header& header,
+      const std::vector<cv::Mat>& specular,
+      const cv::Mat& irradiance
+   );
+   [[nodiscard]] int getLevelNum(int face_size) const;
+   static void getRadianceChain(std::vector<cv::Mat>& chain, const cv::Mat& cubemap);
+   static void getTexelDirection(cv::Vec3f& direction, int face, int x, int y, int face_size);
+   [[nodiscard]] static cv::Vec3f sampleCubemap(const cv::Mat& faces, const cv::Vec3f& direction);
+   [[nodiscard]] static cv::Vec3f sampleCubemap(const std::vector<cv::Mat>& chain, const cv::Vec3f& direction, float lod);
+   void getGGXLobeSamples(std::vector<LobeSample>& samples, float roughness, int source_face_size) const;
+   static void prefilterSpecular(
+      cv::Mat& prefiltered,
+      const std::vector<cv::Mat>& chain,
+      const std::vector<LobeSample>& samples,
+      const cv::Range& row_range
+   );
+   static void convolveIrradiance(cv::Mat& irradiance, const cv::Mat& source, const cv::Range& row_range);
+};
\ No newline at end of file
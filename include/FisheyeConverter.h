@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Shader.h"
+#include "TextureCache.h"
+#include "LongitudeLatitudeMapping.h"
+
+// It converts the fisheye image into the longitude-latitude texture with a compute shader, so the converted image is
+// written straight into the texture without passing through the CPU. The projection and the fixed-point blending are
+// the same as LongitudeLatitudeMapping::convertFisheye(), and compareWithCPU() measures how close they are.
+// An OpenGL 4.3 context or above should be current while it is used.
+class FisheyeConverterGL final
+{
+public:
+   FisheyeConverterGL();
+   ~FisheyeConverterGL();
+
+   FisheyeConverterGL(const FisheyeConverterGL&) = delete;
+   FisheyeConverterGL& operator=(const FisheyeConverterGL&) = delete;
+
+   // The texture has the same size and storage as the one TextureCacheGL uploads from the CPU conversion.
+   [[nodiscard]] TextureCacheGL::Handle convert(const cv::Mat& fisheye);
+   template<typename Lens>
+   [[nodiscard]] TextureCacheGL::Handle convert(const cv::Mat& fisheye, const Lens& lens)
+   {
+      LensParameters parameters;
+      getLensParameters( parameters, lens, fisheye.size() );
+      return convert( fisheye, parameters );
+   }
+   // It converts the fisheye image with each lens model on both sides and prints the differences and the times.
+   // It returns false if any pixel is off by more than a rounding of the coordinates explains.
+   [[nodiscard]] bool compareWithCPU(const cv::Mat& fisheye, int thread_num = 0);
+   static void readTexture(cv::Mat& converted, GLuint texture_id);
+
+private:
+   struct LensParameters
+   {
+      int Model;
+      glm::vec4 Coefficients;
+      float RadiusScale;
+      glm::vec2 OpticalCenter;
+      glm::vec2 ImageCircleRadius;
+   };
+
+   std::unique_ptr<ShaderGL> ConverterShader;
+   GLuint FisheyeTexture;
+   cv::Size FisheyeSize;
+
+   void setShader();
+   void uploadFisheye(const cv::Mat& fisheye);
+   [[nodiscard]] TextureCacheGL::Handle convert(const cv::Mat& fisheye, const LensParameters& parameters);
+   template<typename Lens>
+   [[nodiscard]] bool compareWithCPU(
+      LongitudeLatitudeMapping& mapper,
+      const cv::Mat& fisheye,
+      const Lens& lens,
+      const std::string& lens_name,
+      int thread_num
+   );
+
+   // The model is the first value of the lens key, and the coefficients follow the common values of FisheyeLens.
+   template<typename Lens>
+   static void getLensParameters(LensParameters& parameters, const Lens& lens, const cv::Size& fisheye_size)
+   {
+      const std::vector<double> key = lens.getKey();
+      const cv::Point2d optical_center = lens.getOpticalCenter( fisheye_size );
+      const cv::Point2d image_circle_radius = lens.getImageCircleRadius( fisheye_size );
+      parameters.Model = static_cast<int>(key[0]);
+      parameters.Coefficients = glm::vec4(0.0f);
+      for (size_t i = 6; i < std::min( key.size(), static_cast<size_t>(10) ); ++i) {
+         parameters.Coefficients[static_cast<int>(i - 6)] = static_cast<float>(key[i]);
+      }
+      parameters.RadiusScale = static_cast<float>(1.0 / lens.project( lens.getHalfFieldOfViewInRadian() ));
+      parameters.OpticalCenter = glm::vec2(optical_center.x, optical_center.y);
+      parameters.ImageCircleRadius = glm::vec2(image_circle_radius.x, image_circle_radius.y);
+   }
+};
\ No newline at end of file
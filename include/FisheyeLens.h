@@ -0,0 +1,103 @@
+#pragma once
+
+#include "_Common.h"
+
+// A lens model projects the incident angle from the optical axis onto the radius of the image circle. The radius is
+// normalized so that the incident angle of the half field of view lands on the perimeter of the image circle.
+// The models are plain types with a non-virtual project(), so the conversion is specialized for each of them.
+// The longitude-latitude image keeps only the hemisphere in front of the lens, which is what the environment dome and
+// the reflection in BasicPipeline.frag cover, so a lens wider than 180 degree is projected with its own model but the
+// incident angles over 90 degree are clipped away from the converted image.
+struct FisheyeLens
+{
+   double FieldOfView; // in degree
+   cv::Point2d OpticalCenter; // in pixel, the image center is used if it is negative
+   cv::Point2d ImageCircleRadius; // in pixel along x and y-axis, the half of the image size is used if it is negative
+
+   explicit FisheyeLens(
+      double field_of_view = 180.0,
+      const cv::Point2d& optical_center = cv::Point2d(-1.0, -1.0),
+      const cv::Point2d& image_circle_radius = cv::Point2d(-1.0, -1.0)
+   ) : FieldOfView( field_of_view ), OpticalCenter( optical_center ), ImageCircleRadius( image_circle_radius ) {}
+
+   [[nodiscard]] double getHalfFieldOfViewInRadian() const { return FieldOfView * 0.5 * CV_PI / 180.0; }
+   [[nodiscard]] cv::Point2d getOpticalCenter(const cv::Size& image_size) const
+   {
+      return {
+         OpticalCenter.x < 0.0 ? image_size.width * 0.5 : OpticalCenter.x,
+         OpticalCenter.y < 0.0 ? image_size.height * 0.5 : OpticalCenter.y
+      };
+   }
+   [[nodiscard]] cv::Point2d getImageCircleRadius(const cv::Size& image_size) const
+   {
+      return {
+         ImageCircleRadius.x < 0.0 ? image_size.width * 0.5 : ImageCircleRadius.x,
+         ImageCircleRadius.y < 0.0 ? image_size.height * 0.5 : ImageCircleRadius.y
+      };
+   }
+   [[nodiscard]] std::vector<double> getKey(int model_id) const
+   {
+      return {
+         static_cast<double>(model_id), FieldOfView,
+         OpticalCenter.x, OpticalCenter.y, ImageCircleRadius.x, ImageCircleRadius.y
+      };
+   }
+};
+
+// r = theta
+struct EquidistantLens final : FisheyeLens
+{
+   using FisheyeLens::FisheyeLens;
+   [[nodiscard]] static double project(double angle) { return angle; }
+   [[nodiscard]] std::vector<double> getKey() const { return FisheyeLens::getKey( 0 ); }
+};
+
+// r = 2 * sin(theta / 2)
+struct EquisolidLens final : FisheyeLens
+{
+   using FisheyeLens::FisheyeLens;
+   [[nodiscard]] static double project(double angle) { return 2.0 * sin( angle * 0.5 ); }
+   [[nodiscard]] std::vector<double> getKey() const { return FisheyeLens::getKey( 1 ); }
+};
+
+// r = sin(theta), whose field of view cannot be over 180 degree.
+struct OrthographicLens final : FisheyeLens
+{
+   using FisheyeLens::FisheyeLens;
+   [[nodiscard]] static double project(double angle) { return sin( std::min( angle, CV_PI * 0.5 ) ); }
+   [[nodiscard]] std::vector<double> getKey() const { return FisheyeLens::getKey( 2 ); }
+};
+
+// r = 2 * tan(theta / 2)
+struct StereographicLens final : FisheyeLens
+{
+   using FisheyeLens::FisheyeLens;
+   [[nodiscard]] static double project(double angle) { return 2.0 * tan( angle * 0.5 ); }
+   [[nodiscard]] std::vector<double> getKey() const { return FisheyeLens::getKey( 3 ); }
+};
+
+// r = theta + k1 * theta^3 + k2 * theta^5 + k3 * theta^7 + k4 * theta^9 [Kannala and Brandt, TPAMI 2006]
+struct KannalaBrandtLens final : FisheyeLens
+{
+   std::array<double, 4> Coefficients;
+
+   explicit KannalaBrandtLens(
+      const std::array<double, 4>& coefficients = { 0.0, 0.0, 0.0, 0.0 },
+      double field_of_view = 180.0,
+      const cv::Point2d& optical_center = cv::Point2d(-1.0, -1.0),
+      const cv::Point2d& image_circle_radius = cv::Point2d(-1.0, -1.0)
+   ) : FisheyeLens( field_of_view, optical_center, image_circle_radius ), Coefficients( coefficients ) {}
+
+   [[nodiscard]] double project(double angle) const
+   {
+      const double squared_angle = angle * angle;
+      return angle * (1.0 + squared_angle * (Coefficients[0] + squared_angle * (Coefficients[1] +
+         squared_angle * (Coefficients[2] + squared_angle * Coefficients[3]))));
+   }
+   [[nodiscard]] std::vector<double> getKey() const
+   {
+      std::vector<double> key = FisheyeLens::getKey( 4 );
+      key.insert( key.end(), Coefficients.begin(), Coefficients.end() );
+      return key;
+   }
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "BoundedQueue.h"
+#include "LongitudeLatitudeMapping.h"
+
+// It converts a fisheye video to a longitude-latitude video with three overlapped stages, decode, convert and encode,
+// which are connected by bounded queues. The throughput is limited by the slowest stage, not by the sum of them.
+class FisheyeVideoConverter
+{
+public:
+   // It receives each converted frame in order. Returning false stops the pipeline.
+   using FrameSink = std::function<bool(const cv::Mat& converted, int frame_index)>;
+
+   struct StageReport
+   {
+      std::string Name;
+      int FrameNum;
+      double BusySeconds; // the time spent on its own work, not waiting for the queues
+
+      StageReport() : FrameNum( 0 ), BusySeconds( 0.0 ) {}
+      explicit StageReport(std::string name) : Name( std::move( name ) ), FrameNum( 0 ), BusySeconds( 0.0 ) {}
+   };
+
+   struct QueueReport
+   {
+      std::string Name;
+      size_t Capacity;
+      size_t MaxOccupancy;
+      double AverageOccupancy;
+
+      QueueReport() : Capacity( 0 ), MaxOccupancy( 0 ), AverageOccupancy( 0.0 ) {}
+   };
+
+   struct Report
+   {
+      int FrameNum;
+      double TotalSeconds;
+      std::array<StageReport, 3> Stages;
+      std::array<QueueReport, 2> Queues;
+
+      Report() : FrameNum( 0 ), TotalSeconds( 0.0 ) {}
+   };
+
+   explicit FisheyeVideoConverter(int thread_num = 0, size_t queue_capacity = 4);
+   ~FisheyeVideoConverter() = default;
+
+   template<typename Lens>
+   void setLens(const Lens& lens)
+   {
+      Convert = [this, lens](cv::Mat& converted, const cv::Mat& fisheye) {
+         Mapper.buildFisheyeTable( fisheye.size(), fisheye.size(), lens, ThreadNum );
+         Mapper.convertFisheye( converted, fisheye, lens, ThreadNum );
+      };
+   }
+   bool convert(const std::string& input_path, const std::string& output_path);
+   bool convert(cv::VideoCapture& capture, const FrameSink& sink);
+   [[nodiscard]] const Report& getReport() const { return LastReport; }
+   void printReport() const;
+
+private:
+   struct Frame
+   {
+      int Index;
+      cv::Mat Image;
+
+      Frame() : Index( -1 ) {}
+      Frame(int index, cv::Mat image) : Index( index ), Image( std::move( image ) ) {}
+   };
+
+   int ThreadNum;
+   size_t QueueCapacity;
+   LongitudeLatitudeMapping Mapper;
+   std::function<void(cv::Mat&, const cv::Mat&)> Convert;
+   Report LastReport;
+
+   static double getSecondsSince(const std::chrono::steady_clock::time_point& start);
+   static QueueReport getQueueReport(const std::string& name, const BoundedQueue<Frame>& queue);
+};
\ No newline at end of file
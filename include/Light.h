@@ -2,11 +2,19 @@
 
 #include "Shader.h"
 
+// The lights are packed into one shader storage buffer which BasicPipeline.frag reads at LightBufferBinding.
+// The buffer keeps the lights in eye coordinates and is uploaded again only after a light is added, switched or moved,
+// or the view changes, so binding it is all the other draws cost.
 class LightGL final
 {
 public:
+   inline static constexpr GLuint LightBufferBinding = 0;
+
    LightGL();
-   ~LightGL() = default;
+   ~LightGL();
+
+   LightGL(const LightGL&) = delete;
+   LightGL& operator=(const LightGL&) = delete;
 
    [[nodiscard]] bool isLightOn() const;
    void toggleLightSwitch();
@@ -22,13 +30,41 @@ public:
    );
    void activateLight(const int& light_index);
    void deactivateLight(const int& light_index);
-   void transferUniformsToShader(const ShaderGL* shader);
+   void setLightPosition(int light_index, const glm::vec4& light_position);
+   void bindLightBuffer(const glm::mat4& view_matrix);
    [[nodiscard]] int getTotalLightNum() const { return TotalLightNum; }
    [[nodiscard]] glm::vec4 getLightPosition(int light_index) { return Positions[light_index]; }
 
 private:
+   // std430 layout of LightBuffer in BasicPipeline.frag
+   struct LightBufferHeader
+   {
+      glm::vec4 GlobalAmbient;
+      int UseLight;
+      int LightNum;
+      int Padding[2];
+   };
+
+   struct LightInfo
+   {
+      glm::vec4 PositionInEC;
+      glm::vec4 AmbientColor;
+      glm::vec4 DiffuseColor;
+      glm::vec4 SpecularColor;
+      glm::vec3 SpotlightDirectionInEC;
+      float SpotlightCutoffAngle;
+      float SpotlightFeather;
+      float FallOffRadius;
+      int LightSwitch;
+      int Padding;
+   };
+
    bool TurnLightOn;
+   bool IsDirty;
    int TotalLightNum;
+   GLuint LightBuffer;
+   GLsizeiptr LightBufferSize;
+   glm::mat4 ViewMatrix; // of the last upload
    glm::vec4 GlobalAmbientColor;
    std::vector<bool> IsActivated;
    std::vector<glm::vec4> Positions;
@@ -39,4 +75,6 @@ private:
    std::vector<float> SpotlightCutoffAngles;
    std::vector<float> SpotlightFeathers;
    std::vector<float> FallOffRadii;
+
+   void uploadLightBuffer(const glm::mat4& view_matrix);
 };
\ No newline at end of file
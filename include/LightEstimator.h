@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Shader.h"
+#include "TextureCache.h"
+#include "LightPosition.h"
+
+// It finds the lights of the longitude-latitude texture on the GPU as LightPosition does on the CPU. The adjusted
+// intensities and their summed-area table are built by parallel prefix scans, the regions are cut on the GPU, and only
+// the regions of the lights are read back. The variance cuts are left to LightPosition, which stays as the reference.
+// An OpenGL 4.3 context or above with the double precision in the shaders should be current while it is used.
+class LightEstimatorGL final
+{
+public:
+   LightEstimatorGL();
+   ~LightEstimatorGL();
+
+   LightEstimatorGL(const LightEstimatorGL&) = delete;
+   LightEstimatorGL& operator=(const LightEstimatorGL&) = delete;
+
+   // It returns false for the variance cuts. The lights are sorted and dropped as LightPosition does.
+   [[nodiscard]] bool estimateLightPositions(
+      std::vector<LightPosition::LightInfo>& lights,
+      GLuint longitude_latitude_texture,
+      int light_num_to_find,
+      LightPosition::ALGORITHM algorithm = LightPosition::ALGORITHM::MEDIAN_CUT
+   );
+   // It finds the lights on both sides with each supported algorithm and some numbers of the lights, and prints the
+   // differences and the times. It returns false if any light is different.
+   [[nodiscard]] bool compareWithCPU(const cv::Mat& longitude_latitude);
+   [[nodiscard]] size_t getReadbackBytes() const { return ReadbackBytes; }
+
+private:
+   // std430 layout of Region in MedianCut.comp
+   struct Region
+   {
+      glm::ivec4 Block;
+      glm::ivec2 Center;
+      double Intensity;
+   };
+
+   std::unique_ptr<ShaderGL> EstimatorShader;
+   GLuint IntegralBuffer;
+   GLuint RowWeightBuffer;
+   GLuint RegionBuffer;
+   cv::Size ImageSize;
+   int RegionCapacity;
+   size_t ReadbackBytes;
+
+   void setShader();
+   void prepareBuffers(const cv::Size& image_size, int region_num);
+   void buildIntensityIntegral(GLuint longitude_latitude_texture);
+   // The lights are matched by their blocks, so the order of the lights of the same intensity does not matter.
+   [[nodiscard]] static int getMismatchedLightNum(
+      std::vector<LightPosition::LightInfo> cpu_lights,
+      std::vector<LightPosition::LightInfo> gpu_lights
+   );
+};
\ No newline at end of file
@@ -22,61 +22,77 @@
 class LightPosition
 {
 public:
+   // The adaptive ones always split the region of the largest energy, or of the largest variance, until there are
+   // exactly the requested number of lights, while the others split every region into a power of 2 lights.
+   enum class ALGORITHM { MEDIAN_CUT = 0, VARIANCE_CUT, ADAPTIVE_MEDIAN_CUT, ADAPTIVE_VARIANCE_CUT };
+
+   struct LightInfo
+   {
+      cv::Point Position; // in pixel of the longitude-latitude image
+      cv::Rect Block; // the region of the partition which the light represents
+      float Intensity; // the sum of the adjusted intensities in the block
+
+      LightInfo() : Intensity( 0.0f ) {}
+   };
+
    LightPosition();
    ~LightPosition() = default;
 
    void estimateLightPositions(
-      std::vector<cv::Point>& light_points,  
+      std::vector<LightInfo>& lights,
       const cv::Mat& longitude_latitude,
       int light_num_to_find,
-      bool use_median_cut = true
+      ALGORITHM algorithm = ALGORITHM::MEDIAN_CUT
    );
+   static void drawLightPositions(cv::Mat& image, const std::vector<LightInfo>& lights);
 
 private:
+   struct Region
+   {
+      cv::Rect Block;
+      cv::Point Center;
+      double Priority;
+
+      Region() : Priority( 0.0 ) {}
+      bool operator<(const Region& other) const { return Priority < other.Priority; }
+   };
+
    int LightNum;
    cv::Mat AdjustedIntensities;
-   std::map<float, cv::Point> LightInfos;
+   cv::Mat IntensityIntegral;
+   cv::Mat MomentIntegrals;
+   std::vector<LightInfo> Lights;
 
    static int getNextHighestPowerOf2(int number);
 
-   static void drawLightPosition(cv::Mat& image, const cv::Point& light_position);
-   static void drawBlockLine(cv::Mat& image, const cv::Point& start, const cv::Point& end);
-
+   void addLight(const cv::Point& light_position, const cv::Rect& block);
    void adjustIntensities(const cv::Mat& longitude_latitude);
+   void buildMomentIntegrals();
 
-   static void calculateDeltaXDividingIntensityInHalf(
-      int& dx,
-      const cv::Mat& adjusted, 
-      const cv::Range& row_range,
-      float half_intensity
-   );
-   static void calculateDeltaYDividingIntensityInHalf(
-      int& dy,
-      const cv::Mat& adjusted, 
-      const cv::Range& col_range,
-      float half_intensity
-   );
-   void medianCut(cv::Mat& longitude_latitude, const cv::Rect& block, int iteration);
+   [[nodiscard]] double getIntensitySum(const cv::Rect& region) const;
+   void calculateDeltaXDividingIntensityInHalf(int& dx, const cv::Rect& block, double half_intensity) const;
+   void calculateDeltaYDividingIntensityInHalf(int& dy, const cv::Rect& block, double half_intensity) const;
+   void medianCut(const cv::Rect& block, int iteration);
 
-   [[nodiscard]] static float calculateVariance(
-      const cv::Mat& adjusted, 
-      const cv::Point& center, 
-      const cv::Range& col_range, 
-      const cv::Range& row_range
-   );
-   static void calculateDeltaXMinimizingVariance(
+   [[nodiscard]] cv::Vec3d getMomentSums(const cv::Rect& region) const;
+   [[nodiscard]] float calculateVariance(const cv::Rect& block, const cv::Point& center) const;
+   void calculateDeltaXMinimizingVariance(
       int& dx,
       cv::Point& left_prev_point,
       cv::Point& right_prev_point,
-      const cv::Mat& adjusted, 
-      float total_intensity
-   );
-   static void calculateDeltaYMinimizingVariance(
+      const cv::Rect& block,
+      double total_intensity
+   ) const;
+   void calculateDeltaYMinimizingVariance(
       int& dy,
       cv::Point& top_prev_point,
       cv::Point& bottom_prev_point,
-      const cv::Mat& adjusted, 
-      float total_intensity
-   );
-   void varianceCut(cv::Mat& longitude_latitude, cv::Point& prev_point, const cv::Rect& block, int iteration);
+      const cv::Rect& block,
+      double total_intensity
+   ) const;
+   void varianceCut(const cv::Point& prev_point, const cv::Rect& block, int iteration);
+
+   [[nodiscard]] Region getRegion(const cv::Rect& block, bool use_variance) const;
+   void splitRegion(Region& first, Region& second, const Region& region, bool use_variance) const;
+   void adaptiveCut(int light_num_to_find, bool use_variance);
 };
\ No newline at end of file
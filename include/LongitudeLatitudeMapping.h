@@ -9,7 +9,8 @@
 
 #pragma once
 
-#include "_Common.h"
+#include "BilinearSampler.h"
+#include "FisheyeLens.h"
 
 class LongitudeLatitudeMapping
 {
@@ -17,16 +18,184 @@ public:
    LongitudeLatitudeMapping() = default;
    ~LongitudeLatitudeMapping() = default;
 
-   static void convertFisheye(cv::Mat& converted, const cv::Mat& fisheye);
-   static void convertMirrorball(cv::Mat& converted, const cv::Mat& mirrorball);
+   // The mapping depends only on the image sizes and the lens, so the source coordinates of every converted pixel are
+   // computed once and reused by the later conversions. Building a table ahead of time keeps the first frame from
+   // paying for it. Every converted row is independent, so the rows are split across thread_num threads.
+   // (0 means all cores.) The fisheye functions without a lens assume the 180-degree equidistant lens. Whatever the
+   // field of view of the lens is, the converted image covers only the front hemisphere, whose longitude is [0, PI].
+   void buildFisheyeTable(const cv::Size& fisheye_size, const cv::Size& converted_size, int thread_num = 1);
+   template<typename Lens>
+   void buildFisheyeTable(const cv::Size& fisheye_size, const cv::Size& converted_size, const Lens& lens, int thread_num = 1)
+   {
+      getFisheyeTable( fisheye_size, converted_size, lens, thread_num );
+   }
+   void buildMirrorballTable(const cv::Size& mirrorball_size, const cv::Size& converted_size, int thread_num = 1);
+   void buildCubemapTable(const cv::Size& longitude_latitude_size, int face_size, int thread_num = 1);
+   void clearTables() { RemapTables.clear(); }
+
+   void convertFisheye(cv::Mat& converted, const cv::Mat& fisheye, int thread_num = 1);
+   template<typename Lens>
+   void convertFisheye(cv::Mat& converted, const cv::Mat& fisheye, const Lens& lens, int thread_num = 1)
+   {
+      remap( converted, fisheye, getFisheyeTable( fisheye.size(), fisheye.size(), lens, thread_num ), thread_num );
+   }
+   void convertMirrorball(cv::Mat& converted, const cv::Mat& mirrorball, int thread_num = 1);
+   // It bakes the longitude-latitude image into the six faces of a cube map, which are stacked from top to bottom in
+   // the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face. Each direction is looked up as the reflection in
+   // BasicPipeline.frag looks up the hemisphere from its center, so the directions below the horizon are black.
+   void convertToCubemap(cv::Mat& cubemap, const cv::Mat& longitude_latitude, int face_size, int thread_num = 1);
+   static void getCubemapDirection(cv::Point3d& direction, int face, const cv::Point2d& face_point);
 
 private:
-   static void getBilinearInterpolatedColor(cv::Vec3b& bgr_color, const cv::Mat& image, const cv::Vec2d& point);
+   enum class PROJECTION { FISHEYE = 0, MIRRORBALL, CUBEMAP };
+
+   struct RemapKey
+   {
+      PROJECTION Projection;
+      cv::Size SourceSize;
+      cv::Size ConvertedSize;
+      std::vector<double> LensKey;
+
+      bool operator<(const RemapKey& other) const
+      {
+         return std::make_tuple(
+               Projection, SourceSize.width, SourceSize.height, ConvertedSize.width, ConvertedSize.height, LensKey
+            ) <
+            std::make_tuple(
+               other.Projection,
+               other.SourceSize.width, other.SourceSize.height,
+               other.ConvertedSize.width, other.ConvertedSize.height,
+               other.LensKey
+            );
+      }
+   };
+
+   using RowsCalculator = std::function<void(BilinearSampler::RemapTable&, const cv::Range&)>;
+
+   std::map<RemapKey, BilinearSampler::RemapTable> RemapTables;
+
+   const BilinearSampler::RemapTable& getRemapTable(
+      const RemapKey& key,
+      int thread_num,
+      const RowsCalculator& calculate_rows
+   );
+   template<typename Lens>
+   const BilinearSampler::RemapTable& getFisheyeTable(
+      const cv::Size& fisheye_size,
+      const cv::Size& converted_size,
+      const Lens& lens,
+      int thread_num
+   )
+   {
+      return getRemapTable(
+         { PROJECTION::FISHEYE, fisheye_size, converted_size, lens.getKey() },
+         thread_num,
+         [&](BilinearSampler::RemapTable& table, const cv::Range& row_range) {
+            calculateFisheyeTable( table, fisheye_size, lens, row_range );
+         }
+      );
+   }
+   template<typename Lens>
+   static void calculateFisheyeTable(
+      BilinearSampler::RemapTable& table,
+      const cv::Size& fisheye_size,
+      const Lens& lens,
+      const cv::Range& row_range
+   );
+   const BilinearSampler::RemapTable& getMirrorballTable(
+      const cv::Size& mirrorball_size,
+      const cv::Size& converted_size,
+      int thread_num
+   );
+   static void calculateMirrorballTable(
+      BilinearSampler::RemapTable& table,
+      const cv::Size& mirrorball_size,
+      const cv::Range& row_range
+   );
+   const BilinearSampler::RemapTable& getCubemapTable(
+      const cv::Size& longitude_latitude_size,
+      int face_size,
+      int thread_num
+   );
+   static void calculateCubemapTable(
+      BilinearSampler::RemapTable& table,
+      const cv::Size& longitude_latitude_size,
+      const cv::Range& row_range
+   );
+   static void remap(cv::Mat& converted, const cv::Mat& source, const BilinearSampler::RemapTable& table, int thread_num);
+
    static void getTextureCoordinates(cv::Point2d& texture_point, const cv::Point& image_point, const cv::Size& image_size);
    
    static void getSphereCoordinatesForFisheye(cv::Point3d& on_sphere, const cv::Point2d& longitude_latitude);
-   static void getFisheyeCoordinatesFromSphere(cv::Point2d& fisheye_point, const cv::Point3d& on_sphere);
+   template<typename Lens>
+   static void getFisheyeCoordinatesFromSphere(
+      cv::Point2d& fisheye_point,
+      const cv::Point3d& on_sphere,
+      const Lens& lens,
+      double radius_scale
+   );
 
    static void getSphereCoordinatesForMirrorball(cv::Point3d& on_sphere, const cv::Point2d& longitude_latitude);
    static void getMirrorballCoordinatesFromSphere(cv::Point2d& mirrorball_point, const cv::Point3d& on_sphere);
-};
\ No newline at end of file
+
+   static void getReflectedTextureCoordinates(cv::Point2d& texture_point, const cv::Point3d& on_sphere);
+};
+
+template<typename Lens>
+void LongitudeLatitudeMapping::getFisheyeCoordinatesFromSphere(
+   cv::Point2d& fisheye_point,
+   const cv::Point3d& on_sphere,
+   const Lens& lens,
+   double radius_scale
+)
+// fisheye_point's range is [-1, 1]. It means that fisheye image which is circle has range of [-1, 1].
+// Image point from the half field of view of incidence projected on the perimeter of circle whose radius is 1.
+{
+   const double incident_angle = atan2(
+      sqrt( on_sphere.x * on_sphere.x + on_sphere.y * on_sphere.y ),
+      -on_sphere.z
+   );
+   const double radius = lens.project( incident_angle ) * radius_scale;
+   const double rotation_angle_on_image_plane = atan2( on_sphere.y, on_sphere.x );
+   fisheye_point.x = radius * cos( rotation_angle_on_image_plane );
+   fisheye_point.y = radius * sin( rotation_angle_on_image_plane );
+}
+
+template<typename Lens>
+void LongitudeLatitudeMapping::calculateFisheyeTable(
+   BilinearSampler::RemapTable& table,
+   const cv::Size& fisheye_size,
+   const Lens& lens,
+   const cv::Range& row_range
+)
+{
+   const double radius_scale = 1.0 / lens.project( lens.getHalfFieldOfViewInRadian() );
+   const cv::Point2d optical_center = lens.getOpticalCenter( fisheye_size );
+   const cv::Point2d image_circle_radius = lens.getImageCircleRadius( fisheye_size );
+   const cv::Size& converted_size = table.ConvertedSize;
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      auto* entries = table.Entries.data() + static_cast<size_t>(j) * converted_size.width;
+      for (int i = 0; i < converted_size.width; ++i) {
+         BilinearSampler::getInvalidRemapEntry( entries[i] );
+
+         cv::Point2d texture_point;
+         getTextureCoordinates( texture_point, { i, j }, converted_size );
+
+         cv::Point3d on_sphere;
+         getSphereCoordinatesForFisheye( on_sphere, texture_point );
+
+         cv::Point2d fisheye_point;
+         getFisheyeCoordinatesFromSphere( fisheye_point, on_sphere, lens, radius_scale );
+         if (fisheye_point.x * fisheye_point.x + fisheye_point.y * fisheye_point.y > 1.0) continue;
+
+         cv::Point2d fisheye_image_point;
+         fisheye_image_point.x = optical_center.x + fisheye_point.x * image_circle_radius.x;
+         fisheye_image_point.y = optical_center.y + fisheye_point.y * image_circle_radius.y;
+
+         if (fisheye_image_point.x < 0 || fisheye_image_point.x >= fisheye_size.width ||
+             fisheye_image_point.y < 0 || fisheye_image_point.y >= fisheye_size.height) continue;
+
+         BilinearSampler::getRemapEntry( entries[i], fisheye_image_point, fisheye_size );
+      }
+   }
+}
\ No newline at end of file
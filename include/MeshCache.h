@@ -0,0 +1,64 @@
+#pragma once
+
+#include "_Common.h"
+
+// It converts a text model into a binary cache on the first load and memory-maps the cache on the later loads, so the
+// interleaved vertex attributes go to the GPU without parsing any float.
+// The text model has the polygon number, and then the vertex number and the attributes of every vertex of each polygon.
+// The cache keeps the first floats_per_vertex attributes of every vertex after the header.
+// The cache is rebuilt if the size of the source file changes, or if its modified time changes with a different hash.
+class MeshCache
+{
+public:
+   MeshCache();
+   ~MeshCache();
+
+   MeshCache(const MeshCache&) = delete;
+   MeshCache& operator=(const MeshCache&) = delete;
+
+   bool load(const std::string& text_path, int text_floats_per_vertex, int floats_per_vertex);
+   void unload();
+   [[nodiscard]] const float* getVertexData() const;
+   [[nodiscard]] int getVertexNum() const;
+   [[nodiscard]] int getFloatsPerVertex() const;
+
+private:
+   struct Header
+   {
+      char Magic[4];
+      uint32_t Version;
+      uint32_t FloatsPerVertex;
+      uint32_t VertexNum;
+      uint64_t SourceSize;
+      int64_t SourceModifiedTime;
+      uint64_t SourceHash;
+   };
+
+   inline static constexpr char CacheMagic[4] = { 'E', 'M', 'M', 'C' };
+   inline static constexpr uint32_t CacheVersion = 1;
+
+   uchar* MappedData;
+   size_t MappedSize;
+   Header ParsedHeader; // used only if the cache could not be written
+   std::vector<float> ParsedVertices;
+#ifdef _WIN32
+   void* File;
+   void* Mapping;
+#endif
+
+   [[nodiscard]] static std::string getCachePath(const std::string& text_path);
+   [[nodiscard]] static uint64_t getHash(const std::string& file_path);
+   [[nodiscard]] static bool parseTextModel(
+      std::vector<float>& vertices,
+      const std::string& text_path,
+      int text_floats_per_vertex,
+      int floats_per_vertex
+   );
+   [[nodiscard]] static bool writeCache(const std::string& cache_path, const Header& header, const std::vector<float>& vertices);
+   [[nodiscard]] bool map(const std::string& cache_path);
+   [[nodiscard]] const Header* getHeader() const
+   {
+      return MappedData == nullptr ? &ParsedHeader : reinterpret_cast<const Header*>(MappedData);
+   }
+   [[nodiscard]] bool isValid(int floats_per_vertex) const;
+};
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "_Common.h"
+
+// It turns a triangle soup into indexed triangles and reorders the triangles for the post-transform vertex cache.
+class MeshOptimizer
+{
+public:
+   MeshOptimizer() = default;
+   ~MeshOptimizer() = default;
+
+   // The vertices of the same attributes bit by bit are merged into one, in the order of their first appearances.
+   static void deduplicateVertices(
+      std::vector<GLfloat>& unique_vertices,
+      std::vector<GLuint>& indices,
+      const GLfloat* vertices,
+      int vertex_num,
+      int floats_per_vertex
+   );
+   // Tipsify [Sander et al., Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, SIGGRAPH 2007]
+   static void reorderForVertexCache(std::vector<GLuint>& indices, int vertex_num, int cache_size = 16);
+   // The average number of vertices transformed per triangle with a FIFO cache of cache_size vertices.
+   // It is 3 for a triangle soup and approaches 0.5 for a regular grid.
+   [[nodiscard]] static float getACMR(const std::vector<GLuint>& indices, int vertex_num, int cache_size = 16);
+
+private:
+   [[nodiscard]] static int getNextFanningVertex(
+      std::vector<int>& dead_ends,
+      int& cursor,
+      const std::vector<int>& candidates,
+      const std::vector<int>& live_triangle_nums,
+      const std::vector<int>& cache_times,
+      int time,
+      int cache_size
+   );
+};
\ No newline at end of file
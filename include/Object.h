@@ -1,11 +1,16 @@
 #pragma once
 
 #include "Shader.h"
+#include "TextureCache.h"
 
 class ObjectGL
 {
 public:
-   enum LayoutLocation { VertexLoc = 0, NormalLoc, TextureLoc };
+   enum LayoutLocation { VertexLoc = 0, NormalLoc, TextureLoc, NextVertexLoc, NextNormalLoc };
+
+   // QUANTIZED stores a position in 16-bit unorm against the bounding box with a padding, a normal in 16-bit snorm of
+   // its octahedral encoding, and texture coordinates in half floats, so every attribute is 4-byte aligned.
+   enum class VERTEX_FORMAT { FLOAT32 = 0, QUANTIZED };
 
    ObjectGL();
    ~ObjectGL();
@@ -15,6 +20,7 @@ public:
    void setDiffuseReflectionColor(const glm::vec4& diffuse_reflection_color);
    void setSpecularReflectionColor(const glm::vec4& specular_reflection_color);
    void setSpecularReflectionExponent(const float& specular_reflection_exponent);
+   void setRoughness(float roughness);
    void setObject(GLenum draw_mode, const std::vector<glm::vec3>& vertices);
    void setObject(
       GLenum draw_mode,
@@ -32,6 +38,20 @@ public:
       const std::vector<glm::vec3>& normals,
       const cv::Mat& texture
    );
+   void setObject(GLenum draw_mode, const GLfloat* vertices_and_normals, GLsizei vertex_num);
+   void setObject(
+      GLenum draw_mode,
+      const std::vector<GLfloat>& vertices_and_normals,
+      const std::vector<GLuint>& indices,
+      VERTEX_FORMAT format = VERTEX_FORMAT::FLOAT32
+   );
+   void setKeyframeObject(
+      GLenum draw_mode,
+      const std::vector<const GLfloat*>& keyframes,
+      GLsizei vertex_num,
+      VERTEX_FORMAT format = VERTEX_FORMAT::FLOAT32
+   );
+   void setKeyframes(int keyframe, int next_keyframe) const;
    void setObject(
       GLenum draw_mode,
       const std::vector<glm::vec3>& vertices,
@@ -43,7 +63,8 @@ public:
       GLenum draw_mode,
       const std::vector<glm::vec3>& vertices,
       const std::vector<glm::vec3>& normals,
-      const std::vector<glm::vec2>& textures
+      const std::vector<glm::vec2>& textures,
+      VERTEX_FORMAT format = VERTEX_FORMAT::FLOAT32
    );
    void setObject(
       GLenum draw_mode,
@@ -61,6 +82,7 @@ public:
    );
    int addTexture(const std::string& texture_file_path, bool is_grayscale = false);
    int addTexture(const cv::Mat& texture);
+   int addTexture(const TextureCacheGL::Handle& texture);
    void addTexture(int width, int height, bool is_grayscale = false);
    int addTexture(const uint8_t* image_buffer, int width, int height, bool is_grayscale = false);
    void transferUniformsToShader(const ShaderGL* shader);
@@ -75,8 +97,12 @@ public:
    [[nodiscard]] GLuint getVAO() const { return VAO; }
    [[nodiscard]] GLenum getDrawMode() const { return DrawMode; }
    [[nodiscard]] GLsizei getVertexNum() const { return VerticesCount; }
+   [[nodiscard]] GLsizei getIndexNum() const { return IndicesCount; }
+   [[nodiscard]] VERTEX_FORMAT getVertexFormat() const { return Format; }
    [[nodiscard]] GLuint getTextureID(int index) const { return TextureID[index]; }
    [[nodiscard]] int getTextureNum() const { return static_cast<int>(TextureID.size()); }
+   [[nodiscard]] int getKeyframeNum() const { return KeyframeNum; }
+   [[nodiscard]] GLsizeiptr getBufferSize() const; // of the vertices and the indices in bytes
 
    template<typename T>
    void addShaderStorageBufferObject(const std::string& name, GLuint binding_index, int data_size)
@@ -117,21 +143,55 @@ private:
    std::vector<GLfloat> DataBuffer;
    GLuint VAO;
    GLuint VBO;
+   GLuint EBO;
    GLenum DrawMode;
+   VERTEX_FORMAT Format;
+   glm::vec3 PositionScale; // It dequantizes a position into PositionOffset + PositionScale * position.
+   glm::vec3 PositionOffset;
    std::vector<GLuint> TextureID;
+   std::vector<TextureCacheGL::Handle> SharedTextures; // deleted with their last handle, not by this object
    std::map<std::string, GLuint> CustomBuffers;
    GLsizei VerticesCount;
+   GLsizei IndicesCount;
+   int KeyframeNum;
    glm::vec4 EmissionColor;
    glm::vec4 AmbientReflectionColor; // It is usually set to the same color with DiffuseReflectionColor.
                                      // Otherwise, it should be in balance with DiffuseReflectionColor.
    glm::vec4 DiffuseReflectionColor; // the intrinsic color
    glm::vec4 SpecularReflectionColor;
    float SpecularReflectionExponent;
+   float Roughness; // It selects the GGX-prefiltered level of the reflection cube map, and 0 is a mirror.
 
    [[nodiscard]] bool prepareTexture2DUsingFreeImage(const std::string& file_path, bool is_grayscale) const;
    void prepareTexture(bool normals_exist) const;
    void prepareVertexBuffer(int n_bytes_per_vertex);
+   void prepareVertexBuffer(int n_bytes_per_vertex, const GLfloat* data, size_t n_floats);
+   void prepareVertexBuffer(int n_bytes_per_vertex, const GLvoid* data, size_t n_bytes);
    void prepareNormal() const;
+   void setPositionBounds(
+      const std::vector<const GLfloat*>& vertex_sets,
+      GLsizei vertex_num,
+      int floats_per_vertex
+   );
+   void quantizeVertices(
+      GLushort* quantized,
+      const GLfloat* vertices,
+      GLsizei vertex_num,
+      bool normals_exist,
+      bool textures_exist
+   ) const;
+   void setQuantizedObject(
+      GLenum draw_mode,
+      const GLfloat* vertices,
+      GLsizei vertex_num,
+      bool normals_exist,
+      bool textures_exist
+   );
+   [[nodiscard]] int getKeyframeVertexSize() const
+   {
+      return static_cast<int>(Format == VERTEX_FORMAT::QUANTIZED ? 6 * sizeof( GLushort ) : 6 * sizeof( GLfloat ));
+   }
+   [[nodiscard]] static glm::vec2 getOctahedralEncoding(const glm::vec3& normal);
    static void getSquareObject(
       std::vector<glm::vec3>& vertices,
       std::vector<glm::vec3>& normals,
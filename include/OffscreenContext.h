@@ -0,0 +1,28 @@
+#pragma once
+
+#include "_Common.h"
+
+// It creates an OpenGL context without any visible window, so the renderer runs on the machines without a display.
+// On Linux, it is an EGL context on the surfaceless platform of Mesa, which works with llvmpipe as well. On Windows, it
+// falls back to an invisible GLFW window. Either way, the frames should be drawn into a framebuffer object.
+class OffscreenContextGL
+{
+public:
+   OffscreenContextGL();
+   ~OffscreenContextGL();
+
+   OffscreenContextGL(const OffscreenContextGL&) = delete;
+   OffscreenContextGL& operator=(const OffscreenContextGL&) = delete;
+
+   // It makes the core profile context of the version current and loads the OpenGL functions.
+   [[nodiscard]] bool create(int major_version, int minor_version);
+   void destroy();
+
+private:
+#ifdef _WIN32
+   GLFWwindow* Window;
+#else
+   void* Display; // EGLDisplay
+   void* Context; // EGLContext
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "_Common.h"
+
+// It records the CPU time of each stage and the GPU time of each draw pass for every frame, and the frame time.
+// The GPU times are measured by GL_TIME_ELAPSED queries, which are kept in a ring of QueryRingSize frames and read only
+// when their results are available, so the profiling never waits for the GPU while frames are drawn. The queries of the
+// same target cannot be nested, so only the draw passes, which never overlap, have their GPU times. A pass which runs
+// more than once in a frame gets a query for each run, and both of its times are the sums of the runs.
+// When it is disabled, a Scope costs one branch and no OpenGL call is made.
+class ProfilerGL final
+{
+public:
+   enum class STAGE { UPDATE = 0, RENDER, DRAW_ENVIRONMENT, DRAW_MOVING_TIGER, DRAW_COW, STAGE_NUM };
+
+   // It measures the stage from its construction to its destruction.
+   class Scope final
+   {
+   public:
+      Scope(ProfilerGL* profiler, STAGE stage) :
+         Profiler( profiler != nullptr && profiler->isEnabled() ? profiler : nullptr ), Stage( stage )
+      {
+         if (Profiler != nullptr) Profiler->begin( Stage );
+      }
+      ~Scope()
+      {
+         if (Profiler != nullptr) Profiler->end( Stage );
+      }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+   private:
+      ProfilerGL* Profiler;
+      STAGE Stage;
+   };
+
+   ProfilerGL();
+   ~ProfilerGL();
+
+   ProfilerGL(const ProfilerGL&) = delete;
+   ProfilerGL& operator=(const ProfilerGL&) = delete;
+
+   // Enabling it clears the frames recorded before, and disabling it waits for the results of the queries in flight.
+   // An OpenGL context should be current.
+   void setEnabled(bool enabled);
+   [[nodiscard]] bool isEnabled() const { return Enabled; }
+   // The frame time is from beginFrame() to endFrame(), so endFrame() should be called after the buffers are swapped.
+   void beginFrame();
+   void endFrame();
+   void printReport() const;
+   // Each row is a frame and each column is a stage in milliseconds, which is empty if the stage did not run.
+   [[nodiscard]] bool writeCSV(const std::string& file_path) const;
+   // It has the mean and the percentiles of each column of the CSV, and every frame.
+   [[nodiscard]] bool writeJSON(const std::string& file_path) const;
+   // It is the nearest rank of the sorted values, which should not be empty.
+   [[nodiscard]] static double getPercentile(const std::vector<double>& sorted_values, double percent);
+
+private:
+   inline static constexpr int QueryRingSize = 4;
+   inline static constexpr int StageNum = static_cast<int>(STAGE::STAGE_NUM);
+   inline static constexpr int GPUStageNum = 3; // DRAW_ENVIRONMENT, DRAW_MOVING_TIGER and DRAW_COW
+
+   struct FrameRecord
+   {
+      double FrameTime;
+      std::array<double, StageNum> CPUTimes;
+      std::array<double, GPUStageNum> GPUTimes;
+
+      FrameRecord() : FrameTime( -1.0 ) { CPUTimes.fill( -1.0 ); GPUTimes.fill( -1.0 ); }
+   };
+
+   struct QuerySlot
+   {
+      std::array<std::vector<GLuint>, GPUStageNum> Queries; // grown to the most runs of each pass in a frame
+      std::array<size_t, GPUStageNum> IssuedNums;
+      size_t FrameIndex;
+      bool Pending;
+
+      QuerySlot() : IssuedNums{}, FrameIndex( 0 ), Pending( false ) {}
+   };
+
+   struct Column
+   {
+      std::string Name;
+      std::vector<double> Values; // negative if it is not measured
+   };
+
+   bool Enabled;
+   bool InFrame;
+   size_t DroppedResultNum;
+   std::chrono::steady_clock::time_point FrameStart;
+   std::array<std::chrono::steady_clock::time_point, StageNum> StageStarts;
+   std::array<QuerySlot, QueryRingSize> QueryRing;
+   std::vector<FrameRecord> Frames;
+
+   [[nodiscard]] static const char* getStageName(STAGE stage);
+   [[nodiscard]] static int getGPUStageIndex(STAGE stage);
+   [[nodiscard]] static std::vector<double> getSortedMeasuredValues(const Column& column);
+
+   void begin(STAGE stage);
+   void end(STAGE stage);
+   void collectResults(QuerySlot& slot, bool waits);
+   void getColumns(std::vector<Column>& columns) const;
+};
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "_Common.h"
+
+// It lists the camera poses and the object states to render, one frame per line.
+// Each line has the camera position (x y z), the position it looks at (x y z), the object to draw (cow or tiger),
+// the keyframe of the tiger, the blend toward its next keyframe in [0, 1], and the rotation angle of the tiger in
+// degrees. The empty lines and the lines starting with # are skipped.
+class RenderScript
+{
+public:
+   struct Frame
+   {
+      glm::vec3 CameraPosition;
+      glm::vec3 CameraTarget;
+      bool DrawMovingObject;
+      int TigerIndex;
+      float KeyframeBlend;
+      int TigerRotationAngle;
+
+      Frame() :
+         CameraPosition( 0.0f ), CameraTarget( 0.0f, 0.0f, -1.0f ), DrawMovingObject( false ), TigerIndex( 0 ),
+         KeyframeBlend( 0.0f ), TigerRotationAngle( 0 ) {}
+   };
+
+   RenderScript() = default;
+   ~RenderScript() = default;
+
+   [[nodiscard]] static bool load(std::vector<Frame>& frames, const std::string& script_path);
+};
\ No newline at end of file
@@ -9,8 +9,19 @@
 #include "_Common.h"
 #include "Light.h"
 #include "Object.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 #include "LongitudeLatitudeMapping.h"
+#include "FisheyeConverter.h"
+#include "EnvironmentPrefilter.h"
+#include "SphericalHarmonics.h"
 #include "LightPosition.h"
+#include "LightEstimator.h"
+#include "Profiler.h"
+#include "OffscreenContext.h"
+#include "RenderScript.h"
+#include "CameraPath.h"
+#include "BoundedQueue.h"
 
 class RendererGL
 {
@@ -21,34 +32,85 @@ public:
    RendererGL& operator=(const RendererGL&&) = delete;
 
 
-   RendererGL();
-   ~RendererGL() = default;
+   // An offscreen renderer draws into a framebuffer object of the frame size without any window.
+   explicit RendererGL(bool offscreen = false, int frame_width = 1920, int frame_height = 1080);
+   ~RendererGL();
 
-   void play(const cv::Mat& fisheye);
+   // The profiling is toggled by the t key, and it starts at once if the profile path is given. Whenever it stops, the
+   // report is printed and written into <profile path>.csv and <profile path>.json.
+   // The camera path recording is toggled by the c key, and it is written into <binary directory>/camera_paths.
+   void play(const cv::Mat& fisheye, const std::string& profile_path = "");
+   // It replays the recorded camera path at the fixed step without the vertical sync, whatever the frame rate is, and
+   // writes the frame times into <profile path>.csv and <profile path>.json.
+   bool replayCameraPath(
+      const cv::Mat& fisheye,
+      const std::string& camera_path_file,
+      const std::string& profile_path,
+      double step = 1.0 / 60.0
+   );
+   // It renders every frame of the script as fast as possible and writes frame_#####.png into the output directory,
+   // and the frame times into profile.csv and profile.json.
+   bool renderOffscreen(const cv::Mat& fisheye, const std::string& script_path, const std::string& output_directory_path);
+   // It renders frame_num frames with each reflection mode and prints the GPU time per frame of each.
+   void benchmarkReflection(const cv::Mat& fisheye, int frame_num);
+   // It renders frame_num frames offscreen for every combination of the instance numbers, the light numbers and the frame
+   // sizes, and prints the draw calls, the triangles per second and the frame times of each into the CSV file too.
+   // The instances alternate between the cow and the tiger, and all the lights are switched on.
+   bool benchmarkScenes(
+      const cv::Mat& fisheye,
+      const std::vector<int>& instance_nums,
+      const std::vector<int>& light_nums,
+      const std::vector<cv::Size>& frame_sizes,
+      int frame_num,
+      const std::string& csv_path
+   );
 
 private:
+   enum class REFLECTION_MODE { ANALYTIC = 0, CUBEMAP };
+   enum class LIGHTING_MODE { POINT_LIGHTS = 0, SPHERICAL_HARMONICS };
+
+   inline static constexpr double UpdateInterval = 0.1;
    inline static RendererGL* Renderer = nullptr;
+   std::unique_ptr<OffscreenContextGL> OffscreenContext; // destroyed after every other OpenGL object
    GLFWwindow* Window;
+   GLuint FBO;
+   GLuint ColorBuffer;
+   GLuint DepthBuffer;
    bool DrawMovingObject;
    int FrameWidth;
    int FrameHeight;
    int ActivatedLightIndex;
    int TigerIndex;
+   float KeyframeBlend;
    int TigerRotationAngle;
    float EnvironmentRadius;
+   REFLECTION_MODE ReflectionMode;
+   LIGHTING_MODE LightingMode;
    glm::ivec2 ClickedPoint;
    std::unique_ptr<CameraGL> MainCamera;
    std::unique_ptr<ShaderGL> ObjectShader;
    std::unique_ptr<ShaderGL> EnvironmentShader;
    std::unique_ptr<ObjectGL> EnvironmentObject;
    std::unique_ptr<ObjectGL> CowObject;
-   std::vector<std::unique_ptr<ObjectGL>> MovingTigerObjects;
+   std::unique_ptr<ObjectGL> MovingTigerObject;
    std::unique_ptr<LightGL> Lights;
+   std::unique_ptr<TextureCacheGL> TextureCache;
+   TextureCacheGL::Handle ReflectionCubemap;
+   TextureCacheGL::Handle IrradianceCubemap;
+   SphericalHarmonics::Coefficients IrradianceCoefficients;
    std::unique_ptr<LightPosition> LightFinder;
    std::unique_ptr<LongitudeLatitudeMapping> LongitudeLatitudeMapper;
+   std::unique_ptr<FisheyeConverterGL> FisheyeConverter;
+   std::unique_ptr<LightEstimatorGL> LightEstimator;
+   std::unique_ptr<ProfilerGL> Profiler;
+   std::string ProfilePath;
+   std::unique_ptr<CameraPath> RecordedPath;
+   double RecordingStartTime;
  
    void registerCallbacks() const;
    void initialize();
+   // It creates the framebuffer of the frame size again if it exists.
+   [[nodiscard]] bool setOffscreenFramebuffer();
 
    static void printOpenGLInformation();
 
@@ -67,14 +129,32 @@ private:
    static void mousewheelWrapper(GLFWwindow* window, double xoffset, double yoffset);
    static void reshapeWrapper(GLFWwindow* window, int width, int height);
 
-   void setEnvironmentObject(const cv::Mat& texture);
-   void setMovingTigerObjects(const cv::Mat& texture);
-   void setCowObject(const cv::Mat& texture);
+   void setEnvironmentObject(const TextureCacheGL::Handle& texture);
+   void setMovingTigerObject(const TextureCacheGL::Handle& texture);
+   void setCowObject(const TextureCacheGL::Handle& texture);
+   void printVertexMemory() const;
+   void setReflectionCubemap(const cv::Mat& texture);
+   void setIrradianceCoefficients(const cv::Mat& texture);
+   // The light positions are shown in a HighGUI window only if it is asked, since it needs a display.
+   void setScene(const cv::Mat& fisheye, bool shows_light_positions);
    
-   void findLightsAndGetTexture(cv::Mat& texture, const cv::Mat& fisheye, int light_num_to_find = 5);
+   void findLightsAndGetTexture(
+      cv::Mat& texture,
+      TextureCacheGL::Handle& environment_texture,
+      std::vector<LightPosition::LightInfo>& lights,
+      const cv::Mat& fisheye,
+      int light_num_to_find = 5
+   );
+   static void showLightPositions(const cv::Mat& texture, const std::vector<LightPosition::LightInfo>& lights);
    void drawEnvironment(float scale_factor) const;
-   void drawMovingTiger(float scale_factor, float theta);
-   void drawCow(float scale_factor);
+   void drawMovingTiger(float scale_factor, float theta, const glm::mat4& placement = glm::mat4(1.0f));
+   void drawCow(float scale_factor, const glm::mat4& placement = glm::mat4(1.0f));
    void render();
+   void renderInstances(const std::vector<glm::mat4>& placements);
    void update();
+   void toggleProfiling();
+   void toggleCameraPathRecording();
+   [[nodiscard]] CameraPath::SceneState getSceneState() const;
+   void setSceneState(const CameraPath::SceneState& scene);
+   [[nodiscard]] bool writeProfile(const std::string& profile_path) const;
 };
\ No newline at end of file
@@ -6,28 +6,18 @@
 class ShaderGL
 {
 public:
-   struct LightLocationSet
-   {
-      GLint LightSwitch, LightPosition;
-      GLint LightAmbient, LightDiffuse, LightSpecular, LightFallOffRadius;
-      GLint SpotlightDirection, SpotlightCutoffAngle, SpotlightFeather;
-
-      LightLocationSet() : LightSwitch( 0 ), LightPosition( 0 ), LightAmbient( 0 ), LightDiffuse( 0 ),
-      LightSpecular( 0 ), LightFallOffRadius( 0 ), SpotlightDirection( 0 ), SpotlightCutoffAngle( 0 ),
-      SpotlightFeather( 0 ) {}
-   };
+   inline static constexpr GLuint TransformBlockBinding = 0;
 
    struct LocationSet
    {
-      GLint World, View, Projection, ModelViewProjection;
-      GLint MaterialEmission, MaterialAmbient, MaterialDiffuse, MaterialSpecular, MaterialSpecularExponent;
+      GLint PositionScale, PositionOffset, UseOctahedralNormal;
+      GLint MaterialEmission, MaterialAmbient, MaterialDiffuse, MaterialSpecular, MaterialSpecularExponent, MaterialRoughness;
       std::map<GLint, GLint> Texture; // <binding point, texture id>
-      GLint UseTexture, UseLight, LightNum, GlobalAmbient;
-      std::vector<LightLocationSet> Lights;
+      GLint UseTexture;
 
-      LocationSet() : World( 0 ), View( 0 ), Projection( 0 ), ModelViewProjection( 0 ), MaterialEmission( 0 ),
+      LocationSet() : PositionScale( 0 ), PositionOffset( 0 ), UseOctahedralNormal( 0 ), MaterialEmission( 0 ),
       MaterialAmbient( 0 ), MaterialDiffuse( 0 ), MaterialSpecular( 0 ), MaterialSpecularExponent( 0 ),
-      UseTexture( 0 ), UseLight( 0 ), LightNum( 0 ), GlobalAmbient( 0 ) {}
+      MaterialRoughness( 0 ), UseTexture( 0 ) {}
    };
 
    ShaderGL();
@@ -41,59 +31,38 @@ public:
       const char* tessellation_evaluation_shader_path = nullptr
    );
    void setComputeShaders(const std::vector<const char*>& compute_shader_paths);
-   void setUniformLocations(int light_num);
+   void setUniformLocations();
    void addUniformLocation(const std::string& name);
    void addUniformLocationToComputeShader(const std::string& name, int shader_index);
    void transferBasicTransformationUniforms(const glm::mat4& to_world, const CameraGL* camera, bool use_texture = false) const;
    [[nodiscard]] GLuint getShaderProgram() const { return ShaderProgram; }
+   [[nodiscard]] GLuint getComputeShaderProgram(int shader_index) const { return ComputeShaderPrograms[shader_index]; }
    [[nodiscard]] GLint getLocation(const std::string& name) const { return CustomLocations.find( name )->second; }
+   [[nodiscard]] GLint getPositionScaleLocation() const { return Location.PositionScale; }
+   [[nodiscard]] GLint getPositionOffsetLocation() const { return Location.PositionOffset; }
+   [[nodiscard]] GLint getOctahedralNormalUsageLocation() const { return Location.UseOctahedralNormal; }
    [[nodiscard]] GLint getMaterialEmissionLocation() const { return Location.MaterialEmission; }
    [[nodiscard]] GLint getMaterialAmbientLocation() const { return Location.MaterialAmbient; }
    [[nodiscard]] GLint getMaterialDiffuseLocation() const { return Location.MaterialDiffuse; }
    [[nodiscard]] GLint getMaterialSpecularLocation() const { return Location.MaterialSpecular; }
    [[nodiscard]] GLint getMaterialSpecularExponentLocation() const { return Location.MaterialSpecularExponent; }
-   [[nodiscard]] GLint getLightAvailabilityLocation() const { return Location.UseLight; }
-   [[nodiscard]] GLint getLightNumLocation() const { return Location.LightNum; }
-   [[nodiscard]] GLint getGlobalAmbientLocation() const { return Location.GlobalAmbient; }
-   [[nodiscard]] GLint getLightSwitchLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightSwitch;
-   }
-   [[nodiscard]] GLint getLightPositionLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightPosition;
-   }
-   [[nodiscard]] GLint getLightAmbientLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightAmbient;
-   }
-   [[nodiscard]] GLint getLightDiffuseLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightDiffuse;
-   }
-   [[nodiscard]] GLint getLightSpecularLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightSpecular;
-   }
-   [[nodiscard]] GLint getLightSpotlightDirectionLocation(int light_index) const
-   {
-      return Location.Lights[light_index].SpotlightDirection;
-   }
-   [[nodiscard]] GLint getLightSpotlightCutoffAngleLocation(int light_index) const
-   {
-      return Location.Lights[light_index].SpotlightCutoffAngle;
-   }
-   [[nodiscard]] GLint getLightSpotlightFeatherLocation(int light_index) const
-   {
-      return Location.Lights[light_index].SpotlightFeather;
-   }
-   [[nodiscard]] GLint getLightFallOffRadiusLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightFallOffRadius;
-   }
+   [[nodiscard]] GLint getMaterialRoughnessLocation() const { return Location.MaterialRoughness; }
 
 protected:
+   // std140 layout of TransformBlock in the vertex shaders. The inverses are computed once per draw, not per vertex.
+   struct TransformBlock
+   {
+      glm::mat4 WorldMatrix;
+      glm::mat4 ViewMatrix;
+      glm::mat4 ProjectionMatrix;
+      glm::mat4 ModelViewProjectionMatrix;
+      glm::mat4 WorldNormalMatrix; // transpose(inverse(WorldMatrix))
+      glm::mat4 ViewNormalMatrix; // transpose(inverse(ViewMatrix))
+      glm::vec4 EyePosition; // inverse(ViewMatrix)[3]
+   };
+
    GLuint ShaderProgram;
+   GLuint TransformBuffer;
    LocationSet Location;
    std::unordered_map<std::string, GLint> CustomLocations;
    std::vector<GLuint> ComputeShaderPrograms;
@@ -102,5 +71,4 @@ protected:
    [[nodiscard]] static std::string getShaderTypeString(GLenum shader_type);
    [[nodiscard]] static bool checkCompileError(GLenum shader_type, const GLuint& shader);
    [[nodiscard]] static GLuint getCompiledShader(GLenum shader_type, const char* shader_path);
-   void setBasicTransformationUniforms();
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "_Common.h"
+
+// It projects the environment onto the real spherical harmonics up to the 2nd order, and convolves them with the cosine
+// lobe [Ramamoorthi and Hanrahan, An Efficient Representation for Irradiance Environment Maps, SIGGRAPH 2001].
+// Then the diffuse lighting of any normal is the 9 coefficients times the basis, whatever the number of lights is.
+class SphericalHarmonics
+{
+public:
+   inline static constexpr int CoefficientNum = 9;
+
+   using Coefficients = std::array<glm::vec3, CoefficientNum>; // in RGB, in the order of Y00, Y1-1, Y10, Y11, Y2-2, ...
+
+   SphericalHarmonics() = default;
+   ~SphericalHarmonics() = default;
+
+   // The longitude-latitude image covers the hemisphere as the reflection in BasicPipeline.frag looks it up, and the
+   // directions below the horizon are black. Each pixel is weighted by its solid angle, which is sin(theta) as in
+   // LightPosition::adjustIntensities(). Every row is independent, so the rows are split across thread_num threads.
+   // (0 means all cores.)
+   static void project(Coefficients& radiance, const cv::Mat& longitude_latitude, int thread_num = 1);
+   // The irradiance is divided by PI, so the diffuse color times it is the outgoing radiance of a Lambertian surface.
+   static void convolveWithCosineLobe(Coefficients& irradiance, const Coefficients& radiance);
+   [[nodiscard]] static glm::vec3 evaluate(const Coefficients& coefficients, const glm::vec3& direction);
+
+private:
+   // The sums of the radiance in a row times 1, cos(phi), sin(phi), cos(2phi) and sin(2phi)
+   enum AZIMUTHAL_MOMENT { CONSTANT = 0, COS_PHI, SIN_PHI, COS_2PHI, SIN_2PHI, MOMENT_NUM };
+
+   using RowMoments = std::array<glm::dvec3, MOMENT_NUM>;
+
+   static void getRowMoments(
+      std::vector<RowMoments>& row_moments,
+      const cv::Mat& longitude_latitude,
+      const cv::Mat& azimuthal_bases,
+      const cv::Range& row_range
+   );
+};
\ No newline at end of file
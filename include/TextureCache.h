@@ -0,0 +1,48 @@
+#pragma once
+
+#include "_Common.h"
+
+// It uploads each source image once and hands out shared handles to the texture, which is deleted when the last object
+// holding its handle releases it. The source is identified by its data pointer and format. Each texture keeps a shallow
+// copy of its source, so the pointer cannot be reused by another image while the texture is alive, but the source
+// should not be modified in place after it is uploaded.
+class TextureCacheGL final
+{
+public:
+   using Handle = std::shared_ptr<const GLuint>;
+
+   TextureCacheGL() = default;
+   ~TextureCacheGL() = default;
+
+   [[nodiscard]] Handle getTexture(const cv::Mat& texture);
+   // The six faces are stacked from top to bottom in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face.
+   [[nodiscard]] Handle getCubemapTexture(const cv::Mat& faces);
+   // levels[level] has the faces of each mip level in CV_8UC3 or CV_32FC3, and the texture is identified by levels[0].
+   // If only one level is given, the rest of the mip chain is generated.
+   [[nodiscard]] Handle getCubemapTexture(const std::vector<cv::Mat>& levels);
+   [[nodiscard]] int getTextureNum();
+
+private:
+   struct TextureKey
+   {
+      GLenum Target;
+      const uchar* Data;
+      int Width;
+      int Height;
+      int Type;
+      size_t Step;
+
+      bool operator<(const TextureKey& other) const
+      {
+         return std::make_tuple( Target, Data, Width, Height, Type, Step ) <
+            std::make_tuple( other.Target, other.Data, other.Width, other.Height, other.Type, other.Step );
+      }
+   };
+
+   std::map<TextureKey, std::weak_ptr<const GLuint>> Textures;
+
+   void removeExpiredTextures();
+   [[nodiscard]] Handle getTexture(GLenum target, const std::vector<cv::Mat>& levels);
+   [[nodiscard]] static GLuint uploadTexture(const cv::Mat& texture);
+   [[nodiscard]] static GLuint uploadCubemapTexture(const std::vector<cv::Mat>& levels);
+};
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <gtc/type_ptr.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/quaternion.hpp>
+#include <gtc/packing.hpp>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <gtx/quaternion.hpp>
@@ -16,12 +17,24 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <memory>
+#include <array>
 #include <string>
+#include <cstring>
 #include <map>
+#include <tuple>
 #include <unordered_map>
 #include <sstream>
 #include <fstream>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
 
 #include "ProjectPath.h"
 
@@ -30,4 +43,64 @@ using uint = unsigned int;
 
 constexpr uint OPENGL_COLOR_BUFFER_BIT = 0x00004000u;
 constexpr uint OPENGL_DEPTH_BUFFER_BIT = 0x00000100u;
-constexpr uint OPENGL_STENCIL_BUFFER_BIT = 0x00000400u;
\ No newline at end of file
+constexpr uint OPENGL_STENCIL_BUFFER_BIT = 0x00000400u;
+
+// It runs rows_job(start_row, end_row) over [0, row_num) on thread_num threads, the calling thread included.
+// The rows are handed out in small chunks so that threads which get cheap rows keep taking more.
+// If thread_num is 0, all the hardware threads are used.
+inline void runRowsInParallel(int row_num, int thread_num, const std::function<void(int, int)>& rows_job)
+{
+   if (thread_num <= 0) thread_num = std::max( static_cast<int>(std::thread::hardware_concurrency()), 1 );
+   const int chunk_size = std::max( std::min( row_num / (thread_num * 8), 32 ), 1 );
+   thread_num = std::min( thread_num, (row_num + chunk_size - 1) / chunk_size );
+   if (thread_num <= 1) {
+      if (row_num > 0) rows_job( 0, row_num );
+      return;
+   }
+
+   std::atomic<int> next_row(0);
+   const auto worker = [&]() {
+      for (int start = next_row.fetch_add( chunk_size ); start < row_num; start = next_row.fetch_add( chunk_size )) {
+         rows_job( start, std::min( start + chunk_size, row_num ) );
+      }
+   };
+   std::vector<std::thread> threads;
+   threads.reserve( thread_num - 1 );
+   for (int t = 1; t < thread_num; ++t) threads.emplace_back( worker );
+   worker();
+   for (auto& thread : threads) thread.join();
+}
+
+// 64-bit FNV-1a, which goes on from the given hash, so that data in pieces can be hashed one piece after another.
+constexpr uint64_t FNV1aOffsetBasis = 14695981039346656037ull;
+inline uint64_t getFNV1aHash(const void* data, size_t size, uint64_t hash = FNV1aOffsetBasis)
+{
+   const auto* bytes = static_cast<const uchar*>(data);
+   for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+   }
+   return hash;
+}
+
+// It writes the file by write_contents into a temporary file first and renames it, so a broken file is never left
+// behind. The temporary file is removed if either step fails.
+inline bool writeFileAtomically(const std::string& file_path, const std::function<void(std::ofstream&)>& write_contents)
+{
+   const std::string temporary_path = file_path + ".tmp";
+   bool written;
+   {
+      std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+      if (!file.is_open()) return false;
+
+      write_contents( file );
+      written = file.good();
+   }
+   std::error_code error;
+   if (written) std::filesystem::rename( temporary_path, file_path, error );
+   if (!written || error) {
+      std::filesystem::remove( temporary_path, error );
+      return false;
+   }
+   return true;
+}
\ No newline at end of file
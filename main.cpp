@@ -1,11 +1,174 @@
 #include "Renderer.h"
+#include "FisheyeVideoConverter.h"
 
-int main()
+#include <charconv>
+
+// The whole text should be a number, so that "abc" or "640x" is rejected instead of being read in part or throwing.
+template<typename T>
+static bool parseNumber(T& number, const std::string& text)
+{
+   const char* end = text.data() + text.size();
+   const auto [last, error] = std::from_chars( text.data(), end, number );
+   return !text.empty() && error == std::errc() && last == end;
+}
+
+static bool parseNumbers(std::vector<int>& numbers, const std::string& list, int min_number)
+{
+   std::string item;
+   std::istringstream stream(list);
+   numbers.clear();
+   while (std::getline( stream, item, ',' )) {
+      int number;
+      if (!parseNumber( number, item ) || number < min_number) return false;
+      numbers.emplace_back( number );
+   }
+   return !numbers.empty();
+}
+
+static bool parseFrameSize(cv::Size& frame_size, const std::string& text)
 {
+   const size_t x = text.find( 'x' );
+   return x != std::string::npos &&
+      parseNumber( frame_size.width, text.substr( 0, x ) ) && frame_size.width > 0 &&
+      parseNumber( frame_size.height, text.substr( x + 1 ) ) && frame_size.height > 0;
+}
+
+static bool parseFrameSizes(std::vector<cv::Size>& frame_sizes, const std::string& list)
+{
+   std::string item;
+   std::istringstream stream(list);
+   frame_sizes.clear();
+   while (std::getline( stream, item, ',' )) {
+      cv::Size frame_size;
+      if (!parseFrameSize( frame_size, item )) return false;
+      frame_sizes.emplace_back( frame_size );
+   }
+   return !frame_sizes.empty();
+}
+
+static int printUsage(const std::string& usage)
+{
+   std::cerr << "Usage: EnvironmentMapping " << usage << "\n";
+   return 1;
+}
+
+int main(int argc, char** argv)
+{
+   // EnvironmentMapping --video <input> <output> [thread number]
+   if (argc >= 4 && std::string(argv[1]) == "--video") {
+      int thread_num = 0;
+      if (argc >= 5 && (!parseNumber( thread_num, argv[4] ) || thread_num < 0)) {
+         return printUsage( "--video <input> <output> [thread number >= 0]" );
+      }
+      FisheyeVideoConverter converter(thread_num);
+      const bool succeeded = converter.convert( argv[2], argv[3] );
+      converter.printReport();
+      return succeeded ? 0 : 1;
+   }
+
    const std::string sample_directory_path = std::string(CMAKE_SOURCE_DIR) + "/samples";
    const cv::Mat image = cv::imread( sample_directory_path + "/fisheye/sky.jpg" );
 
+   // EnvironmentMapping --compare-fisheye-conversion [fisheye image]
+   if (argc >= 2 && std::string(argv[1]) == "--compare-fisheye-conversion") {
+      const cv::Mat fisheye = argc >= 3 ? cv::imread( argv[2] ) : image;
+      OffscreenContextGL context;
+      if (fisheye.empty() || !context.create( 4, 5 )) return 1;
+      FisheyeConverterGL converter;
+      return converter.compareWithCPU( fisheye ) ? 0 : 1;
+   }
+
+   // EnvironmentMapping --compare-light-estimation [fisheye image]
+   if (argc >= 2 && std::string(argv[1]) == "--compare-light-estimation") {
+      const cv::Mat fisheye = argc >= 3 ? cv::imread( argv[2] ) : image;
+      OffscreenContextGL context;
+      if (fisheye.empty() || !context.create( 4, 5 )) return 1;
+      cv::Mat longitude_latitude;
+      LongitudeLatitudeMapping().convertFisheye( longitude_latitude, fisheye, 0 );
+      LightEstimatorGL estimator;
+      return estimator.compareWithCPU( longitude_latitude ) ? 0 : 1;
+   }
+
+   // EnvironmentMapping --offscreen <script> <output directory> [width] [height]
+   if (argc >= 4 && std::string(argv[1]) == "--offscreen") {
+      int width = 1920, height = 1080;
+      if ((argc >= 5 && (!parseNumber( width, argv[4] ) || width <= 0)) ||
+          (argc >= 6 && (!parseNumber( height, argv[5] ) || height <= 0))) {
+         return printUsage( "--offscreen <script> <output directory> [width > 0] [height > 0]" );
+      }
+      RendererGL offscreen_renderer(true, width, height);
+      return offscreen_renderer.renderOffscreen( image, argv[2], argv[3] ) ? 0 : 1;
+   }
+
+   // EnvironmentMapping --replay-offscreen <camera path> [profile path without extension] [step] [width] [height]
+   if (argc >= 3 && std::string(argv[1]) == "--replay-offscreen") {
+      double step = 1.0 / 60.0;
+      int width = 1920, height = 1080;
+      if ((argc >= 5 && (!parseNumber( step, argv[4] ) || step <= 0.0)) ||
+          (argc >= 6 && (!parseNumber( width, argv[5] ) || width <= 0)) ||
+          (argc >= 7 && (!parseNumber( height, argv[6] ) || height <= 0))) {
+         return printUsage(
+            "--replay-offscreen <camera path> [profile path without extension] [step in seconds > 0] [width > 0] "
+            "[height > 0]"
+         );
+      }
+      RendererGL offscreen_renderer(true, width, height);
+      return offscreen_renderer.replayCameraPath(
+         image, argv[2], argc >= 4 ? argv[3] : std::string(CMAKE_BINARY_DIR) + "/profiles/replay", step
+      ) ? 0 : 1;
+   }
+
+   // EnvironmentMapping --benchmark-scenes [instance numbers] [light numbers] [frame sizes] [frame number] [csv path]
+   // e.g. --benchmark-scenes 1,4,16,64 1,4,16 640x360,1920x1080 100
+   if (argc >= 2 && std::string(argv[1]) == "--benchmark-scenes") {
+      std::vector<int> instance_nums, light_nums;
+      std::vector<cv::Size> frame_sizes;
+      int frame_num = 100;
+      if (!parseNumbers( instance_nums, argc >= 3 ? argv[2] : "1,4,16,64", 0 ) ||
+          !parseNumbers( light_nums, argc >= 4 ? argv[3] : "1,4,16", 0 ) ||
+          !parseFrameSizes( frame_sizes, argc >= 5 ? argv[4] : "640x360,1920x1080" ) ||
+          (argc >= 6 && (!parseNumber( frame_num, argv[5] ) || frame_num <= 0))) {
+         return printUsage(
+            "--benchmark-scenes [instance numbers, e.g. 1,4,16] [light numbers, e.g. 0,4] "
+            "[frame sizes, e.g. 640x360,1920x1080] [frame number > 0] [csv path]"
+         );
+      }
+
+      RendererGL offscreen_renderer(true, frame_sizes[0].width, frame_sizes[0].height);
+      return offscreen_renderer.benchmarkScenes(
+         image, instance_nums, light_nums, frame_sizes, frame_num,
+         argc >= 7 ? argv[6] : std::string(CMAKE_BINARY_DIR) + "/profiles/scenes.csv"
+      ) ? 0 : 1;
+   }
+
+   // EnvironmentMapping --replay <camera path> [profile path without extension] [step in seconds]
+   if (argc >= 3 && std::string(argv[1]) == "--replay") {
+      double step = 1.0 / 60.0;
+      if (argc >= 5 && (!parseNumber( step, argv[4] ) || step <= 0.0)) {
+         return printUsage( "--replay <camera path> [profile path without extension] [step in seconds > 0]" );
+      }
+      RendererGL renderer;
+      return renderer.replayCameraPath(
+         image, argv[2], argc >= 4 ? argv[3] : std::string(CMAKE_BINARY_DIR) + "/profiles/replay", step
+      ) ? 0 : 1;
+   }
+   // EnvironmentMapping --benchmark-reflection [frame number]
+   if (argc >= 2 && std::string(argv[1]) == "--benchmark-reflection") {
+      int frame_num = 1000;
+      if (argc >= 3 && (!parseNumber( frame_num, argv[2] ) || frame_num <= 0)) {
+         return printUsage( "--benchmark-reflection [frame number > 0]" );
+      }
+      RendererGL renderer;
+      renderer.benchmarkReflection( image, frame_num );
+      return 0;
+   }
+
    RendererGL renderer;
+   // EnvironmentMapping --profile [output path without extension]
+   if (argc >= 2 && std::string(argv[1]) == "--profile") {
+      renderer.play( image, argc >= 3 ? argv[2] : std::string(CMAKE_BINARY_DIR) + "/profiles/profile" );
+      return 0;
+   }
    renderer.play( image );
    return 0;
 }
\ No newline at end of file
@@ -1,20 +1,24 @@
-#version 460
-
-#define MAX_LIGHTS 32
+#version 450
 
 struct LightInfo
 {
-   int LightSwitch;
-   vec4 Position;
+   vec4 PositionInEC;
    vec4 AmbientColor;
    vec4 DiffuseColor;
    vec4 SpecularColor;
-   vec3 SpotlightDirection;
+   vec3 SpotlightDirectionInEC; // normalized
    float SpotlightCutoffAngle;
    float SpotlightFeather;
    float FallOffRadius;
+   int LightSwitch;
+};
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+   vec4 GlobalAmbient;
+   int UseLight;
+   int LightNum;
+   LightInfo Lights[];
 };
-uniform LightInfo Lights[MAX_LIGHTS];
 
 struct MateralInfo {
    vec4 EmissionColor;
@@ -22,25 +26,26 @@ struct MateralInfo {
    vec4 DiffuseColor;
    vec4 SpecularColor;
    float SpecularExponent;
+   float Roughness;
 };
 uniform MateralInfo Material;
 
 layout (binding = 0) uniform sampler2D BaseTexture;
+layout (binding = 1) uniform samplerCube ReflectionTexture; // a GGX-prefiltered level per roughness
+layout (binding = 2) uniform samplerCube IrradianceTexture;
 uniform int UseTexture;
 uniform float EnvironmentRadius;
-
-uniform int UseLight;
-uniform int LightNum;
-uniform vec4 GlobalAmbient;
-
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
+// 0 intersects the hemisphere with the global ambient light, and 1 looks up ReflectionTexture baked from its center
+// with IrradianceTexture as the ambient light.
+uniform int ReflectionMode;
+// 0 loops over the lights, and 1 evaluates IrradianceCoefficients in constant time whatever the number of lights is.
+uniform int LightingMode;
+uniform vec3 IrradianceCoefficients[9]; // the spherical harmonics of the environment convolved with the cosine lobe
 
 in vec3 position_in_wc;
 in vec3 normal_in_wc;
 in vec3 eye_position_in_wc;
 
-in vec3 light_position_in_ec;
 in vec3 position_in_ec;
 in vec3 normal_in_ec;
 
@@ -71,9 +76,7 @@ float getSpotlightFactor(in vec3 normalized_light_vector, in int light_index)
 {
    if (Lights[light_index].SpotlightCutoffAngle >= 180.0f) return one;
 
-   vec4 direction_in_ec = transpose( inverse( ViewMatrix ) ) * vec4(Lights[light_index].SpotlightDirection, zero);
-   vec3 normalized_direction = normalize( direction_in_ec.xyz );
-   float factor = dot( -normalized_light_vector, normalized_direction );
+   float factor = dot( -normalized_light_vector, Lights[light_index].SpotlightDirectionInEC );
    float cutoff_angle = radians( clamp( Lights[light_index].SpotlightCutoffAngle, zero, 90.0f ) );
    if (factor >= cos( cutoff_angle )) {
       float normalized_angle = acos( factor ) * half_pi / cutoff_angle;
@@ -84,14 +87,20 @@ float getSpotlightFactor(in vec3 normalized_light_vector, in int light_index)
    return zero;
 }
 
+vec4 getAmbientLight()
+{
+   if (ReflectionMode == 0) return GlobalAmbient;
+   return vec4(textureLod( IrradianceTexture, normalize( normal_in_wc ), zero ).rgb, one);
+}
+
 vec4 calculateLightingEquation()
 {
-   vec4 color = Material.EmissionColor + GlobalAmbient * Material.AmbientColor;
+   vec4 color = Material.EmissionColor + getAmbientLight() * Material.AmbientColor;
 
    for (int i = 0; i < LightNum; ++i) {
       if (Lights[i].LightSwitch == 0) continue;
       
-      vec4 light_position_in_ec = ViewMatrix * Lights[i].Position;
+      vec4 light_position_in_ec = Lights[i].PositionInEC;
       
       float final_effect_factor = one;
       vec3 light_vector = light_position_in_ec.xyz - position_in_ec;
@@ -122,6 +131,28 @@ vec4 calculateLightingEquation()
    return color;
 }
 
+vec3 getIrradianceFromSphericalHarmonics(in vec3 normal)
+// It is the same as SphericalHarmonics::evaluate().
+{
+   return
+      IrradianceCoefficients[0] * 0.282095f +
+      IrradianceCoefficients[1] * (0.488603f * normal.y) +
+      IrradianceCoefficients[2] * (0.488603f * normal.z) +
+      IrradianceCoefficients[3] * (0.488603f * normal.x) +
+      IrradianceCoefficients[4] * (1.092548f * normal.x * normal.y) +
+      IrradianceCoefficients[5] * (1.092548f * normal.y * normal.z) +
+      IrradianceCoefficients[6] * (0.315392f * (3.0f * normal.z * normal.z - one)) +
+      IrradianceCoefficients[7] * (1.092548f * normal.x * normal.z) +
+      IrradianceCoefficients[8] * (0.546274f * (normal.x * normal.x - normal.y * normal.y));
+}
+
+vec4 calculateSphericalHarmonicsLighting()
+// The 2nd order rings a little around the dark lower hemisphere, so the irradiance is clamped at zero.
+{
+   vec3 irradiance = max( getIrradianceFromSphericalHarmonics( normalize( normal_in_wc ) ), vec3(zero) );
+   return Material.EmissionColor + vec4(irradiance, one) * Material.DiffuseColor;
+}
+
 vec3 calculateReflectedTextureInWC()
 /*
    Hemisphere Equation: x^2 + y^2 + z^2 = 1, 0 <= y <= 1
@@ -165,15 +196,32 @@ vec3 calculateReflectedTextureInWC()
    return reflected_texture;
 }
 
+vec3 calculateReflectedTextureFromCubemap()
+// ReflectionTexture is baked as calculateReflectedTextureInWC() sees the hemisphere from its center, so it is exact for
+// the points near the center and loses the parallax of the points far from it.
+// Its mip levels are prefiltered for the roughness from 0 to 1, so one lookup gives the reflection of any material.
+{
+   vec3 view_vector = normalize( position_in_wc - eye_position_in_wc );
+   vec3 normal = normalize( normal_in_wc );
+   vec3 reflected = reflect( view_vector, normal );
+   if (dot( reflected, normal ) < zero) return vec3(zero);
+
+   float max_lod = float(textureQueryLevels( ReflectionTexture ) - 1);
+   return textureLod( ReflectionTexture, reflected, Material.Roughness * max_lod ).rgb;
+}
+
 void main()
 {
    if (UseTexture == 0) final_color = vec4(one);
    else final_color = texture( BaseTexture, tex_coord );
 
-   if (UseLight != 0) {
+   if (LightingMode != 0) {
+      final_color *= calculateSphericalHarmonicsLighting();
+   }
+   else if (UseLight != 0) {
       final_color *= calculateLightingEquation();
    }
    else final_color *= Material.DiffuseColor;
 
-   final_color.xyz += calculateReflectedTextureInWC();
+   final_color.xyz += ReflectionMode == 0 ? calculateReflectedTextureInWC() : calculateReflectedTextureFromCubemap();
 }
\ No newline at end of file
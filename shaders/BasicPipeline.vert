@@ -1,15 +1,26 @@
-#version 460
-
-uniform mat4 WorldMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ModelViewProjectionMatrix;
-
-uniform vec3 ActivatedLightPosition;
+#version 450
+
+layout (std140, binding = 0) uniform TransformBlock
+{
+   mat4 WorldMatrix;
+   mat4 ViewMatrix;
+   mat4 ProjectionMatrix;
+   mat4 ModelViewProjectionMatrix;
+   mat4 WorldNormalMatrix;
+   mat4 ViewNormalMatrix;
+   vec4 EyePosition;
+};
+
+uniform float KeyframeBlend; // 0 for the objects without keyframes
+uniform vec3 PositionScale; // (1, 1, 1) and (0, 0, 0) for the objects in floats
+uniform vec3 PositionOffset;
+uniform int UseOctahedralNormal;
 
 layout (location = 0) in vec3 v_position;
 layout (location = 1) in vec3 v_normal;
 layout (location = 2) in vec2 v_tex_coord;
+layout (location = 3) in vec3 v_next_position;
+layout (location = 4) in vec3 v_next_normal;
 
 out vec3 position_in_wc;
 out vec3 normal_in_wc;
@@ -17,27 +28,36 @@ out vec3 eye_position_in_wc;
 
 out vec3 position_in_ec;
 out vec3 normal_in_ec;
-out vec3 light_position_in_ec;
 
 out vec2 tex_coord;
 
+vec3 getOctahedralNormal(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0f - abs( encoded.x ) - abs( encoded.y ));
+   float fold = max( -normal.z, 0.0f );
+   normal.x += normal.x >= 0.0f ? -fold : fold;
+   normal.y += normal.y >= 0.0f ? -fold : fold;
+   return normalize( normal );
+}
+
 void main()
 {   
-   vec4 w_position = WorldMatrix * vec4(v_position, 1.0f);
-   vec4 w_normal = transpose( inverse( WorldMatrix ) ) * vec4(v_normal, 1.0f);
+   vec3 position = PositionOffset + PositionScale * mix( v_position, v_next_position, KeyframeBlend );
+   vec3 normal = UseOctahedralNormal != 0 ?
+      normalize( mix( getOctahedralNormal( v_normal.xy ), getOctahedralNormal( v_next_normal.xy ), KeyframeBlend ) ) :
+      mix( v_normal, v_next_normal, KeyframeBlend );
+   vec4 w_position = WorldMatrix * vec4(position, 1.0f);
+   vec4 w_normal = WorldNormalMatrix * vec4(normal, 1.0f);
    position_in_wc = w_position.xyz;
    normal_in_wc = w_normal.xyz;
-   eye_position_in_wc = inverse( ViewMatrix )[3].xyz;
+   eye_position_in_wc = EyePosition.xyz;
    
    vec4 e_position = ViewMatrix * w_position;
-   vec4 e_normal = transpose( inverse( ViewMatrix ) ) * w_normal;
+   vec4 e_normal = ViewNormalMatrix * w_normal;
    position_in_ec = e_position.xyz;
    normal_in_ec = e_normal.xyz;
 
    tex_coord = v_tex_coord;
-   
-   const float light_distance = 10.0f;
-   light_position_in_ec = vec3(ViewMatrix * vec4(light_distance * ActivatedLightPosition, 1.0));
 
-   gl_Position = ModelViewProjectionMatrix * vec4(v_position, 1.0f);
+   gl_Position = ModelViewProjectionMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
@@ -1,7 +1,19 @@
-#version 460
+#version 450
+
+layout (std140, binding = 0) uniform TransformBlock
+{
+   mat4 WorldMatrix;
+   mat4 ViewMatrix;
+   mat4 ProjectionMatrix;
+   mat4 ModelViewProjectionMatrix;
+   mat4 WorldNormalMatrix;
+   mat4 ViewNormalMatrix;
+   vec4 EyePosition;
+};
 
-uniform mat4 ModelViewProjectionMatrix;
 uniform vec3 PrimitiveColor;
+uniform vec3 PositionScale; // (1, 1, 1) and (0, 0, 0) for the objects in floats
+uniform vec3 PositionOffset;
 
 layout (location = 0) in vec4 v_position;
 
@@ -12,9 +24,10 @@ const float pi = 3.14159265358979323846264338327950288f;
 
 void main() 
 {
-   tex_coord.x = atan( -v_position.y, v_position.x ) / pi;
-   tex_coord.y = acos( -v_position.z ) / pi;
+   vec4 position = vec4(PositionOffset + PositionScale * v_position.xyz, 1.0f);
+   tex_coord.x = atan( -position.y, position.x ) / pi;
+   tex_coord.y = acos( -position.z ) / pi;
 
    color = vec4( PrimitiveColor, 1.0f );                  
-   gl_Position =  ModelViewProjectionMatrix * v_position; 
+   gl_Position =  ModelViewProjectionMatrix * position; 
 }
\ No newline at end of file
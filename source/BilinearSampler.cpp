@@ -0,0 +1,272 @@
+#include "BilinearSampler.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BILINEAR_SAMPLER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+BilinearSampler::INSTRUCTION_SET BilinearSampler::getSupportedInstructionSet()
+{
+#if defined(BILINEAR_SAMPLER_X86)
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid( info, 0 );
+   const int max_id = info[0];
+   __cpuid( info, 1 );
+   const bool sse41 = (info[2] & (1 << 19)) != 0;
+   const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv( 0 ) & 6) == 6;
+   bool avx2 = false;
+   if (max_id >= 7 && os_saves_ymm) {
+      __cpuidex( info, 7, 0 );
+      avx2 = (info[1] & (1 << 5)) != 0;
+   }
+#else
+   __builtin_cpu_init();
+   const bool sse41 = __builtin_cpu_supports( "sse4.1" ) != 0;
+   const bool avx2 = __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+   if (avx2) return INSTRUCTION_SET::AVX2;
+   if (sse41) return INSTRUCTION_SET::SSE41;
+#endif
+   return INSTRUCTION_SET::SCALAR;
+}
+
+BilinearSampler::INSTRUCTION_SET& BilinearSampler::getSelectedInstructionSet()
+{
+   static INSTRUCTION_SET selected = getSupportedInstructionSet();
+   return selected;
+}
+
+void BilinearSampler::setInstructionSet(INSTRUCTION_SET instruction_set)
+{
+   const INSTRUCTION_SET supported = getSupportedInstructionSet();
+   getSelectedInstructionSet() =
+      static_cast<int>(instruction_set) <= static_cast<int>(supported) ? instruction_set : supported;
+}
+
+void BilinearSampler::getRemapEntry(RemapEntry& entry, const cv::Point2d& point, const cv::Size& source_size)
+// The source image should be at least 2x2 and the point should be in [0, width) x [0, height).
+// On the last column or row, the taps are moved inward and the far tap takes the full weight, which is the same as
+// clamping the far tap. Then the four taps and the 8-byte loads of the SIMD paths never leave the source image.
+{
+   int x0 = static_cast<int>(floor( point.x ));
+   int y0 = static_cast<int>(floor( point.y ));
+   double tx = point.x - static_cast<double>(x0);
+   double ty = point.y - static_cast<double>(y0);
+   if (x0 >= source_size.width - 1) {
+      x0 = source_size.width - 2;
+      tx = 1.0;
+   }
+   if (y0 >= source_size.height - 1) {
+      y0 = source_size.height - 2;
+      ty = 1.0;
+   }
+
+   const auto wx = static_cast<ushort>(cvRound( tx * WeightOne ));
+   const auto wy = static_cast<ushort>(cvRound( ty * WeightOne ));
+   entry.Offset = (y0 * source_size.width + x0) * 3;
+   entry.Weights[0] = static_cast<ushort>(WeightOne - wx);
+   entry.Weights[1] = wx;
+   entry.Weights[2] = static_cast<ushort>(WeightOne - wy);
+   entry.Weights[3] = wy;
+}
+
+void BilinearSampler::getInvalidRemapEntry(RemapEntry& entry)
+{
+   entry.Offset = 0;
+   entry.Weights[0] = entry.Weights[1] = entry.Weights[2] = entry.Weights[3] = 0;
+}
+
+void BilinearSampler::remapScalar(
+   uchar* converted_ptr,
+   const uchar* source,
+   int source_step,
+   const RemapEntry* entries,
+   int num
+)
+{
+   constexpr int rounding = 1 << (2 * WeightBits - 1);
+   for (int i = 0; i < num; ++i) {
+      const RemapEntry& entry = entries[i];
+      const uchar* top = source + entry.Offset;
+      const uchar* bottom = top + source_step;
+      for (int c = 0; c < 3; ++c) {
+         const int top_blend = top[c] * entry.Weights[0] + top[c + 3] * entry.Weights[1];
+         const int bottom_blend = bottom[c] * entry.Weights[0] + bottom[c + 3] * entry.Weights[1];
+         converted_ptr[c] = static_cast<uchar>(
+            (top_blend * entry.Weights[2] + bottom_blend * entry.Weights[3] + rounding) >> (2 * WeightBits)
+         );
+      }
+      converted_ptr += 3;
+   }
+}
+
+#if defined(BILINEAR_SAMPLER_X86)
+TARGET_SSE41
+void BilinearSampler::remapSSE41(
+   uchar* converted_ptr,
+   const uchar* source,
+   int source_step,
+   const RemapEntry* entries,
+   int num
+)
+// The top row is loaded from the top-left tap and the bottom row is loaded so that it ends at the bottom-right tap.
+// Both 8-byte loads, [B0 G0 R0 B1 G1 R1 x x] and [x x B0 G0 R0 B1 G1 R1], are shuffled into 16-bit pairs of
+// (B0, B1), (G0, G1), (R0, R1) so that one madd blends each row horizontally.
+{
+   const __m128i top_mask = _mm_setr_epi8( 0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1 );
+   const __m128i bottom_mask = _mm_setr_epi8( 10, -1, 13, -1, 11, -1, 14, -1, 12, -1, 15, -1, -1, -1, -1, -1 );
+   const __m128i top_weight_mask = _mm_setr_epi8( 4, 5, -1, -1, 4, 5, -1, -1, 4, 5, -1, -1, 4, 5, -1, -1 );
+   const __m128i bottom_weight_mask = _mm_setr_epi8( 6, 7, -1, -1, 6, 7, -1, -1, 6, 7, -1, -1, 6, 7, -1, -1 );
+   const __m128i rounding = _mm_set1_epi32( 1 << (2 * WeightBits - 1) );
+   for (int i = 0; i < num; ++i) {
+      const RemapEntry& entry = entries[i];
+      const __m128i top = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(source + entry.Offset) );
+      const __m128i bottom = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(source + entry.Offset + source_step - 2) );
+      const __m128i taps = _mm_unpacklo_epi64( top, bottom );
+
+      const __m128i weights = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(entry.Weights) );
+      const __m128i horizontal = _mm_shuffle_epi32( weights, 0 );
+      const __m128i top_blend = _mm_madd_epi16( _mm_shuffle_epi8( taps, top_mask ), horizontal );
+      const __m128i bottom_blend = _mm_madd_epi16( _mm_shuffle_epi8( taps, bottom_mask ), horizontal );
+      __m128i blend = _mm_add_epi32(
+         _mm_mullo_epi32( top_blend, _mm_shuffle_epi8( weights, top_weight_mask ) ),
+         _mm_mullo_epi32( bottom_blend, _mm_shuffle_epi8( weights, bottom_weight_mask ) )
+      );
+      blend = _mm_srli_epi32( _mm_add_epi32( blend, rounding ), 2 * WeightBits );
+      blend = _mm_packs_epi32( blend, blend );
+      blend = _mm_packus_epi16( blend, blend );
+
+      // Writing 4 bytes is fine except for the last pixel because the next pixel overwrites the 4th byte.
+      const int bgr = _mm_cvtsi128_si32( blend );
+      std::memcpy( converted_ptr, &bgr, i + 1 < num ? 4 : 3 );
+      converted_ptr += 3;
+   }
+}
+
+TARGET_AVX2
+void BilinearSampler::remapAVX2(
+   uchar* converted_ptr,
+   const uchar* source,
+   int source_step,
+   const RemapEntry* entries,
+   int num
+)
+// It is the same as remapSSE41 except that each 128-bit lane blends one pixel, so two pixels are done at once.
+{
+   const __m256i top_mask = _mm256_setr_epi8(
+      0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1,
+      0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1
+   );
+   const __m256i bottom_mask = _mm256_setr_epi8(
+      10, -1, 13, -1, 11, -1, 14, -1, 12, -1, 15, -1, -1, -1, -1, -1,
+      10, -1, 13, -1, 11, -1, 14, -1, 12, -1, 15, -1, -1, -1, -1, -1
+   );
+   const __m256i top_weight_mask = _mm256_setr_epi8(
+      4, 5, -1, -1, 4, 5, -1, -1, 4, 5, -1, -1, 4, 5, -1, -1,
+      4, 5, -1, -1, 4, 5, -1, -1, 4, 5, -1, -1, 4, 5, -1, -1
+   );
+   const __m256i bottom_weight_mask = _mm256_setr_epi8(
+      6, 7, -1, -1, 6, 7, -1, -1, 6, 7, -1, -1, 6, 7, -1, -1,
+      6, 7, -1, -1, 6, 7, -1, -1, 6, 7, -1, -1, 6, 7, -1, -1
+   );
+   const __m256i rounding = _mm256_set1_epi32( 1 << (2 * WeightBits - 1) );
+   int i = 0;
+   for (; i + 1 < num; i += 2) {
+      const RemapEntry& first = entries[i];
+      const RemapEntry& second = entries[i + 1];
+      const __m128i first_taps = _mm_unpacklo_epi64(
+         _mm_loadl_epi64( reinterpret_cast<const __m128i*>(source + first.Offset) ),
+         _mm_loadl_epi64( reinterpret_cast<const __m128i*>(source + first.Offset + source_step - 2) )
+      );
+      const __m128i second_taps = _mm_unpacklo_epi64(
+         _mm_loadl_epi64( reinterpret_cast<const __m128i*>(source + second.Offset) ),
+         _mm_loadl_epi64( reinterpret_cast<const __m128i*>(source + second.Offset + source_step - 2) )
+      );
+      const __m256i taps = _mm256_inserti128_si256( _mm256_castsi128_si256( first_taps ), second_taps, 1 );
+
+      const __m256i weights = _mm256_inserti128_si256(
+         _mm256_castsi128_si256( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(first.Weights) ) ),
+         _mm_loadl_epi64( reinterpret_cast<const __m128i*>(second.Weights) ),
+         1
+      );
+      const __m256i horizontal = _mm256_shuffle_epi32( weights, 0 );
+      const __m256i top_blend = _mm256_madd_epi16( _mm256_shuffle_epi8( taps, top_mask ), horizontal );
+      const __m256i bottom_blend = _mm256_madd_epi16( _mm256_shuffle_epi8( taps, bottom_mask ), horizontal );
+      __m256i blend = _mm256_add_epi32(
+         _mm256_mullo_epi32( top_blend, _mm256_shuffle_epi8( weights, top_weight_mask ) ),
+         _mm256_mullo_epi32( bottom_blend, _mm256_shuffle_epi8( weights, bottom_weight_mask ) )
+      );
+      blend = _mm256_srli_epi32( _mm256_add_epi32( blend, rounding ), 2 * WeightBits );
+      blend = _mm256_packs_epi32( blend, blend );
+      blend = _mm256_packus_epi16( blend, blend );
+
+      const int first_bgr = _mm256_cvtsi256_si32( blend );
+      const int second_bgr = _mm256_extract_epi32( blend, 4 );
+      std::memcpy( converted_ptr, &first_bgr, 4 );
+      std::memcpy( converted_ptr + 3, &second_bgr, i + 2 < num ? 4 : 3 );
+      converted_ptr += 6;
+   }
+   if (i < num) remapScalar( converted_ptr, source, source_step, entries + i, num - i );
+}
+#else
+void BilinearSampler::remapSSE41(
+   uchar* converted_ptr,
+   const uchar* source,
+   int source_step,
+   const RemapEntry* entries,
+   int num
+)
+{
+   remapScalar( converted_ptr, source, source_step, entries, num );
+}
+
+void BilinearSampler::remapAVX2(
+   uchar* converted_ptr,
+   const uchar* source,
+   int source_step,
+   const RemapEntry* entries,
+   int num
+)
+{
+   remapScalar( converted_ptr, source, source_step, entries, num );
+}
+#endif
+
+void BilinearSampler::remap(
+   cv::Mat& converted,
+   const cv::Mat& source,
+   const RemapTable& table,
+   const cv::Range& row_range
+)
+{
+   assert( source.type() == CV_8UC3 && source.isContinuous() && source.size() == table.SourceSize );
+   assert( converted.type() == CV_8UC3 && converted.size() == table.ConvertedSize );
+
+   using RemapFunction = void (*)(uchar*, const uchar*, int, const RemapEntry*, int);
+   RemapFunction remap_row;
+   switch (getSelectedInstructionSet()) {
+      case INSTRUCTION_SET::AVX2: remap_row = remapAVX2; break;
+      case INSTRUCTION_SET::SSE41: remap_row = remapSSE41; break;
+      default: remap_row = remapScalar; break;
+   }
+
+   const auto source_step = static_cast<int>(source.step);
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      remap_row(
+         converted.ptr<uchar>(j),
+         source.data,
+         source_step,
+         table.Entries.data() + static_cast<size_t>(j) * converted.cols,
+         converted.cols
+      );
+   }
+}
\ No newline at end of file
@@ -118,6 +118,24 @@ void CameraGL::resetCamera()
    ProjectionMatrix = glm::perspective( glm::radians( InitFOV ), AspectRatio, NearPlane, FarPlane );
 }
 
+void CameraGL::setPose(
+   const glm::vec3& cam_position,
+   const glm::vec3& view_reference_position,
+   const glm::vec3& view_up_vector
+)
+{
+   ViewMatrix = lookAt( cam_position, view_reference_position, view_up_vector );
+   updateCamera();
+}
+
+void CameraGL::setState(const glm::vec3& cam_position, const glm::quat& orientation, float fov)
+{
+   ViewMatrix = glm::mat4_cast( orientation ) * translate( glm::mat4(1.0f), -cam_position );
+   CamPos = cam_position;
+   FOV = fov;
+   ProjectionMatrix = glm::perspective( glm::radians( FOV ), AspectRatio, NearPlane, FarPlane );
+}
+
 void CameraGL::updateWindowSize(int width, int height)
 {
    Width = width;
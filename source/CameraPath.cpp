@@ -0,0 +1,136 @@
+#include "CameraPath.h"
+
+void CameraPath::begin(const SceneState& scene)
+{
+   Scene = scene;
+   CameraStates.clear();
+   KeyEvents.clear();
+}
+
+void CameraPath::addCameraState(double time, const CameraGL& camera)
+{
+   CameraState state;
+   state.Time = time;
+   state.Position = camera.getCameraPosition();
+   state.Orientation = camera.getOrientation();
+   state.FOV = camera.getFieldOfView();
+   CameraStates.emplace_back( state );
+}
+
+void CameraPath::addKey(double time, int key)
+{
+   KeyEvents.push_back( { time, key } );
+}
+
+bool CameraPath::save(const std::string& file_path) const
+{
+   std::ofstream file(file_path);
+   if (!file.is_open()) {
+      std::cerr << "Could not write camera path " << file_path << "\n";
+      return false;
+   }
+
+   file << "# scene: object, reflection mode, lighting mode, light on, activated light, tiger keyframe, tiger angle\n";
+   file << "# camera: time, position (x y z), orientation (w x y z), field of view\n";
+   file << "# key: time, GLFW key code\n";
+   file << "scene " << (Scene.DrawMovingObject ? "tiger " : "cow ") << Scene.ReflectionMode << " " << Scene.LightingMode
+      << " " << (Scene.LightOn ? 1 : 0) << " " << Scene.ActivatedLightIndex << " " << Scene.TigerIndex << " "
+      << Scene.TigerRotationAngle << "\n";
+   file << std::fixed << std::setprecision( 6 );
+   size_t k = 0;
+   for (const auto& state : CameraStates) {
+      for (; k < KeyEvents.size() && KeyEvents[k].Time <= state.Time; ++k) {
+         file << KeyEvents[k].Time << " key " << KeyEvents[k].Key << "\n";
+      }
+      file << state.Time << " camera " << state.Position.x << " " << state.Position.y << " " << state.Position.z << " "
+         << state.Orientation.w << " " << state.Orientation.x << " " << state.Orientation.y << " "
+         << state.Orientation.z << " " << state.FOV << "\n";
+   }
+   for (; k < KeyEvents.size(); ++k) file << KeyEvents[k].Time << " key " << KeyEvents[k].Key << "\n";
+   return static_cast<bool>(file);
+}
+
+bool CameraPath::load(const std::string& file_path)
+{
+   begin( SceneState() );
+   std::ifstream file(file_path);
+   if (!file.is_open()) {
+      std::cerr << "Could not open camera path " << file_path << "\n";
+      return false;
+   }
+
+   std::string line;
+   for (int line_number = 1; std::getline( file, line ); ++line_number) {
+      const size_t first = line.find_first_not_of( " \t\r" );
+      if (first == std::string::npos || line[first] == '#') continue;
+
+      std::istringstream fields(line);
+      std::string type;
+      bool parsed = false;
+      if (line.compare( first, 5, "scene" ) == 0) {
+         std::string object;
+         int light_on = 0;
+         fields >> type >> object >> Scene.ReflectionMode >> Scene.LightingMode >> light_on
+            >> Scene.ActivatedLightIndex >> Scene.TigerIndex >> Scene.TigerRotationAngle;
+         parsed = !fields.fail() && (object == "cow" || object == "tiger");
+         Scene.DrawMovingObject = object == "tiger";
+         Scene.LightOn = light_on != 0;
+      }
+      else {
+         double time = 0.0;
+         fields >> time >> type;
+         if (type == "camera") {
+            CameraState state;
+            state.Time = time;
+            fields >> state.Position.x >> state.Position.y >> state.Position.z
+               >> state.Orientation.w >> state.Orientation.x >> state.Orientation.y >> state.Orientation.z >> state.FOV;
+            parsed = !fields.fail() && (CameraStates.empty() || CameraStates.back().Time <= time);
+            state.Orientation = normalize( state.Orientation );
+            CameraStates.emplace_back( state );
+         }
+         else if (type == "key") {
+            KeyEvent event{ time, 0 };
+            fields >> event.Key;
+            parsed = !fields.fail();
+            KeyEvents.emplace_back( event );
+         }
+      }
+      if (!parsed) {
+         std::cerr << "Could not parse line " << line_number << " of camera path " << file_path << "\n";
+         begin( SceneState() );
+         return false;
+      }
+   }
+   if (CameraStates.empty()) {
+      std::cerr << "Camera path " << file_path << " has no camera state.\n";
+      return false;
+   }
+   std::stable_sort(
+      KeyEvents.begin(), KeyEvents.end(),
+      [](const KeyEvent& a, const KeyEvent& b) { return a.Time < b.Time; }
+   );
+   return true;
+}
+
+CameraPath::CameraState CameraPath::getCameraState(double time) const
+{
+   if (CameraStates.empty()) return CameraState();
+   if (time <= CameraStates.front().Time) return CameraStates.front();
+   if (time >= CameraStates.back().Time) return CameraStates.back();
+
+   const auto next = std::upper_bound(
+      CameraStates.begin(), CameraStates.end(), time,
+      [](double t, const CameraState& state) { return t < state.Time; }
+   );
+   const auto& from = *std::prev( next );
+   const auto& to = *next;
+   const double span = to.Time - from.Time;
+   const auto t = static_cast<float>(span > 0.0 ? (time - from.Time) / span : 0.0);
+
+   CameraState state;
+   state.Time = time;
+   state.Position = glm::mix( from.Position, to.Position, t );
+   state.Orientation = glm::slerp( from.Orientation, to.Orientation, t );
+   state.FOV = glm::mix( from.FOV, to.FOV, t );
+   return state;
+}
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "EnvironmentPrefilter.h"
+
+#include <filesystem>
+
+EnvironmentPrefilter::EnvironmentPrefilter(int sample_num, int min_face_size, int irradiance_face_size) :
+   SampleNum( std::max( sample_num, 1 ) ), MinFaceSize( std::max( min_face_size, 1 ) ),
+   IrradianceFaceSize( std::max( irradiance_face_size, 1 ) )
+{
+}
+
+uint64_t EnvironmentPrefilter::getHash(const cv::Mat& cubemap)
+{
+   uint64_t hash = FNV1aOffsetBasis;
+   const size_t row_size = static_cast<size_t>(cubemap.cols) * cubemap.elemSize();
+   for (int j = 0; j < cubemap.rows; ++j) hash = getFNV1aHash( cubemap.ptr( j ), row_size, hash );
+   return hash;
+}
+
+std::string EnvironmentPrefilter::getCachePath(uint64_t source_hash)
+{
+   const std::string cache_directory_path = std::string(CMAKE_BINARY_DIR) + "/environment_cache";
+   std::error_code error;
+   std::filesystem::create_directories( cache_directory_path, error );
+
+   std::ostringstream file_name;
+   file_name << std::hex << std::setw( 16 ) << std::setfill( '0' ) << source_hash << ".envmap";
+   return cache_directory_path + "/" + file_name.str();
+}
+
+bool EnvironmentPrefilter::readCache(
+   std::vector<cv::Mat>& specular,
+   cv::Mat& irradiance,
+   const std::string& cache_path,
+   const Header& header
+)
+{
+   std::ifstream file(cache_path, std::ios::binary);
+   if (!file.is_open()) return false;
+
+   Header cached_header{};
+   file.read( reinterpret_cast<char*>(&cached_header), sizeof( Header ) );
+   if (!file.good() || std::memcmp( &cached_header, &header, sizeof( Header ) ) != 0) return false;
+
+   const auto read = [&file](cv::Mat& faces, int face_size) {
+      faces.create( face_size * 6, face_size, CV_32FC3 );
+      file.read( reinterpret_cast<char*>(faces.data), static_cast<std::streamsize>(faces.total() * faces.elemSize()) );
+   };
+   specular.resize( header.LevelNum );
+   for (uint32_t level = 0; level < header.LevelNum; ++level) {
+      read( specular[level], std::max( static_cast<int>(header.FaceSize >> level), 1 ) );
+   }
+   read( irradiance, static_cast<int>(header.IrradianceFaceSize) );
+   return file.good() && file.peek() == std::ifstream::traits_type::eof();
+}
+
+bool EnvironmentPrefilter::writeCache(
+   const std::string& cache_path,
+   const Header& header,
+   const std::vector<cv::Mat>& specular,
+   const cv::Mat& irradiance
+)
+{
+   return writeFileAtomically(
+      cache_path,
+      [&](std::ofstream& file) {
+         const auto write = [&file](const cv::Mat& faces) {
+            file.write(
+               reinterpret_cast<const char*>(faces.data), static_cast<std::streamsize>(faces.total() * faces.elemSize())
+            );
+         };
+         file.write( reinterpret_cast<const char*>(&header), sizeof( Header ) );
+         for (const auto& faces : specular) write( faces );
+         write( irradiance );
+      }
+   );
+}
+
+int EnvironmentPrefilter::getLevelNum(int face_size) const
+{
+   int level_num = 1;
+   while ((face_size >> level_num) >= MinFaceSize) level_num++;
+   return level_num;
+}
+
+void EnvironmentPrefilter::getRadianceChain(std::vector<cv::Mat>& chain, const cv::Mat& cubemap)
+// The chain stops at an odd face size, so the area filter of the stacked faces never mixes two faces.
+{
+   chain.resize( 1 );
+   cubemap.convertTo( chain[0], CV_32FC3, 1.0 / 255.0 );
+   while (chain.back().cols > 1 && chain.back().cols % 2 == 0) {
+      const cv::Mat& source = chain.back();
+      cv::Mat half;
+      cv::resize( source, half, cv::Size(source.cols / 2, source.rows / 2), 0.0, 0.0, cv::INTER_AREA );
+      chain.emplace_back( half );
+   }
+}
+
+void EnvironmentPrefilter::getTexelDirection(cv::Vec3f& direction, int face, int x, int y, int face_size)
+{
+   cv::Point3d on_cube;
+   LongitudeLatitudeMapping::getCubemapDirection(
+      on_cube, face, { 2.0 * (x + 0.5) / face_size - 1.0, 2.0 * (y + 0.5) / face_size - 1.0 }
+   );
+   on_cube /= cv::norm( on_cube );
+   direction = cv::Vec3f(static_cast<float>(on_cube.x), static_cast<float>(on_cube.y), static_cast<float>(on_cube.z));
+}
+
+cv::Vec3f EnvironmentPrefilter::sampleCubemap(const cv::Mat& faces, const cv::Vec3f& direction)
+// It selects the face as the major axis table of the cube map in the OpenGL specification, and filters bilinearly
+// within the face. The texels across the edge are not blended, which is hardly visible after the prefiltering.
+{
+   const float ax = std::abs( direction[0] );
+   const float ay = std::abs( direction[1] );
+   const float az = std::abs( direction[2] );
+   int face;
+   float sc, tc, ma;
+   if (ax >= ay && ax >= az) {
+      face = direction[0] >= 0.0f ? 0 : 1;
+      sc = direction[0] >= 0.0f ? -direction[2] : direction[2];
+      tc = -direction[1];
+      ma = ax;
+   }
+   else if (ay >= az) {
+      face = direction[1] >= 0.0f ? 2 : 3;
+      sc = direction[0];
+      tc = direction[1] >= 0.0f ? direction[2] : -direction[2];
+      ma = ay;
+   }
+   else {
+      face = direction[2] >= 0.0f ? 4 : 5;
+      sc = direction[2] >= 0.0f ? direction[0] : -direction[0];
+      tc = -direction[1];
+      ma = az;
+   }
+
+   const int face_size = faces.cols;
+   const float max_point = static_cast<float>(face_size - 1);
+   const float x = std::clamp( (sc / ma + 1.0f) * 0.5f * static_cast<float>(face_size) - 0.5f, 0.0f, max_point );
+   const float y = std::clamp( (tc / ma + 1.0f) * 0.5f * static_cast<float>(face_size) - 0.5f, 0.0f, max_point );
+   const int x0 = static_cast<int>(x);
+   const int y0 = static_cast<int>(y);
+   const int x1 = std::min( x0 + 1, face_size - 1 );
+   const int y1 = std::min( y0 + 1, face_size - 1 );
+   const float fx = x - static_cast<float>(x0);
+   const float fy = y - static_cast<float>(y0);
+   const auto* top = faces.ptr<cv::Vec3f>( face * face_size + y0 );
+   const auto* bottom = faces.ptr<cv::Vec3f>( face * face_size + y1 );
+   return (top[x0] * (1.0f - fx) + top[x1] * fx) * (1.0f - fy) + (bottom[x0] * (1.0f - fx) + bottom[x1] * fx) * fy;
+}
+
+cv::Vec3f EnvironmentPrefilter::sampleCubemap(
+   const std::vector<cv::Mat>& chain,
+   const cv::Vec3f& direction,
+   float lod
+)
+{
+   lod = std::clamp( lod, 0.0f, static_cast<float>(chain.size() - 1) );
+   const int level = static_cast<int>(lod);
+   const float blend = lod - static_cast<float>(level);
+   const cv::Vec3f color = sampleCubemap( chain[level], direction );
+   if (blend <= 0.0f) return color;
+   return color * (1.0f - blend) + sampleCubemap( chain[level + 1], direction ) * blend;
+}
+
+void EnvironmentPrefilter::getGGXLobeSamples(
+   std::vector<LobeSample>& samples,
+   float roughness,
+   int source_face_size
+) const
+/*
+   The halfway vectors are importance-sampled from the GGX distribution of alpha = roughness^2 with the Hammersley
+   points, and the view vector is assumed to be the normal [Karis, Real Shading in Unreal Engine 4, SIGGRAPH 2013].
+   Each sample reads the source mip level whose texel covers the solid angle of the sample, which removes the aliasing
+   of a few samples on a sharp source [Krivanek and Colbert, Real-time Shading with Filtered Importance Sampling, 2008].
+*/
+{
+   const float alpha = roughness * roughness;
+   const float alpha_squared = alpha * alpha;
+   const float texel_solid_angle =
+      4.0f * static_cast<float>(CV_PI) / (6.0f * static_cast<float>(source_face_size * source_face_size));
+
+   samples.clear();
+   samples.reserve( SampleNum );
+   for (int i = 0; i < SampleNum; ++i) {
+      uint bits = static_cast<uint>(i);
+      bits = (bits << 16u) | (bits >> 16u);
+      bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+      bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+      bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+      bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+      const float u = static_cast<float>(i) / static_cast<float>(SampleNum);
+      const float v = static_cast<float>(bits) * 2.3283064365386963e-10f;
+
+      const float phi = 2.0f * static_cast<float>(CV_PI) * u;
+      const float cos_theta = std::sqrt( (1.0f - v) / (1.0f + (alpha_squared - 1.0f) * v) );
+      const float sin_theta = std::sqrt( 1.0f - cos_theta * cos_theta );
+      const float n_dot_l = 2.0f * cos_theta * cos_theta - 1.0f;
+      if (n_dot_l <= 0.0f) continue;
+
+      const float d = cos_theta * cos_theta * (alpha_squared - 1.0f) + 1.0f;
+      const float pdf = alpha_squared / (static_cast<float>(CV_PI) * d * d) * 0.25f;
+      const float sample_solid_angle = 1.0f / (static_cast<float>(SampleNum) * pdf + 1e-6f);
+
+      LobeSample sample;
+      sample.Direction = cv::Vec3f(
+         2.0f * cos_theta * sin_theta * std::cos( phi ),
+         2.0f * cos_theta * sin_theta * std::sin( phi ),
+         n_dot_l
+      );
+      sample.Weight = n_dot_l;
+      sample.Lod = std::max( 0.5f * std::log2( sample_solid_angle / texel_solid_angle ) + 1.0f, 0.0f );
+      samples.emplace_back( sample );
+   }
+}
+
+void EnvironmentPrefilter::prefilterSpecular(
+   cv::Mat& prefiltered,
+   const std::vector<cv::Mat>& chain,
+   const std::vector<LobeSample>& samples,
+   const cv::Range& row_range
+)
+{
+   const int face_size = prefiltered.cols;
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      auto* row = prefiltered.ptr<cv::Vec3f>( j );
+      for (int i = 0; i < face_size; ++i) {
+         cv::Vec3f normal;
+         getTexelDirection( normal, j / face_size, i, j % face_size, face_size );
+         const cv::Vec3f up = std::abs( normal[2] ) < 0.999f ? cv::Vec3f(0.0f, 0.0f, 1.0f) : cv::Vec3f(1.0f, 0.0f, 0.0f);
+         const cv::Vec3f tangent = cv::normalize( up.cross( normal ) );
+         const cv::Vec3f bitangent = normal.cross( tangent );
+
+         cv::Vec3f sum(0.0f, 0.0f, 0.0f);
+         float weight_sum = 0.0f;
+         for (const auto& sample : samples) {
+            const cv::Vec3f direction =
+               tangent * sample.Direction[0] + bitangent * sample.Direction[1] + normal * sample.Direction[2];
+            sum += sampleCubemap( chain, direction, sample.Lod ) * sample.Weight;
+            weight_sum += sample.Weight;
+         }
+         row[i] = weight_sum > 0.0f ? sum / weight_sum : sampleCubemap( chain[0], normal );
+      }
+   }
+}
+
+void EnvironmentPrefilter::convolveIrradiance(cv::Mat& irradiance, const cv::Mat& source, const cv::Range& row_range)
+// The irradiance is divided by PI, so the diffuse color times it is the outgoing radiance of a Lambertian surface.
+// The source is small enough to integrate every texel weighted by its solid angle.
+{
+   const int source_face_size = source.cols;
+   const float texel_area = 4.0f / static_cast<float>(source_face_size * source_face_size);
+   std::vector<cv::Vec3f> directions(source.total());
+   std::vector<cv::Vec3f> radiances(source.total());
+   for (int y = 0; y < source.rows; ++y) {
+      const float t = 2.0f * (static_cast<float>(y % source_face_size) + 0.5f) / source_face_size - 1.0f;
+      for (int x = 0; x < source_face_size; ++x) {
+         const float s = 2.0f * (static_cast<float>(x) + 0.5f) / source_face_size - 1.0f;
+         const float r = 1.0f + s * s + t * t;
+         const size_t index = static_cast<size_t>(y) * source_face_size + x;
+         getTexelDirection( directions[index], y / source_face_size, x, y % source_face_size, source_face_size );
+         radiances[index] = source.at<cv::Vec3f>( y, x ) * (texel_area / (r * std::sqrt( r )));
+      }
+   }
+
+   const int face_size = irradiance.cols;
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      auto* row = irradiance.ptr<cv::Vec3f>( j );
+      for (int i = 0; i < face_size; ++i) {
+         cv::Vec3f normal;
+         getTexelDirection( normal, j / face_size, i, j % face_size, face_size );
+
+         cv::Vec3f sum(0.0f, 0.0f, 0.0f);
+         for (size_t k = 0; k < directions.size(); ++k) {
+            const float cosine = normal.dot( directions[k] );
+            if (cosine > 0.0f) sum += radiances[k] * cosine;
+         }
+         row[i] = sum / static_cast<float>(CV_PI);
+      }
+   }
+}
+
+bool EnvironmentPrefilter::prefilter(
+   std::vector<cv::Mat>& specular,
+   cv::Mat& irradiance,
+   const cv::Mat& cubemap,
+   int thread_num
+)
+{
+   if (cubemap.empty() || cubemap.type() != CV_8UC3 || cubemap.cols * 6 != cubemap.rows) {
+      std::cerr << "The cube map to prefilter should be a BGR image of the six faces stacked from top to bottom.\n";
+      specular.clear();
+      irradiance.release();
+      return false;
+   }
+
+   const int face_size = cubemap.cols;
+   Header header{};
+   std::memcpy( header.Magic, CacheMagic, sizeof( CacheMagic ) );
+   header.Version = CacheVersion;
+   header.FaceSize = static_cast<uint32_t>(face_size);
+   header.LevelNum = static_cast<uint32_t>(getLevelNum( face_size ));
+   header.SampleNum = static_cast<uint32_t>(SampleNum);
+   header.IrradianceFaceSize = static_cast<uint32_t>(IrradianceFaceSize);
+   header.SourceHash = getHash( cubemap );
+   const std::string cache_path = getCachePath( header.SourceHash );
+   if (readCache( specular, irradiance, cache_path, header )) return true;
+
+   std::vector<cv::Mat> chain;
+   getRadianceChain( chain, cubemap );
+
+   specular.resize( header.LevelNum );
+   specular[0] = chain[0].clone();
+   std::vector<LobeSample> samples;
+   for (int level = 1; level < static_cast<int>(header.LevelNum); ++level) {
+      const int level_face_size = face_size >> level;
+      getGGXLobeSamples( samples, static_cast<float>(level) / static_cast<float>(header.LevelNum - 1), face_size );
+      specular[level].create( level_face_size * 6, level_face_size, CV_32FC3 );
+      runRowsInParallel(
+         specular[level].rows, thread_num,
+         [&](int start, int end) { prefilterSpecular( specular[level], chain, samples, { start, end } ); }
+      );
+   }
+
+   auto source = std::find_if(
+      chain.begin(), chain.end(), [](const cv::Mat& faces) { return faces.cols <= IrradianceSourceFaceSize; }
+   );
+   if (source == chain.end()) source = std::prev( chain.end() );
+   irradiance.create( IrradianceFaceSize * 6, IrradianceFaceSize, CV_32FC3 );
+   runRowsInParallel(
+      irradiance.rows, thread_num,
+      [&](int start, int end) { convolveIrradiance( irradiance, *source, { start, end } ); }
+   );
+
+   if (!writeCache( cache_path, header, specular, irradiance )) {
+      std::cerr << "Could not write environment cache " << cache_path << ".\n";
+   }
+   return false;
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "FisheyeConverter.h"
+
+FisheyeConverterGL::FisheyeConverterGL() : FisheyeTexture( 0 )
+{
+}
+
+FisheyeConverterGL::~FisheyeConverterGL()
+{
+   if (FisheyeTexture != 0) glDeleteTextures( 1, &FisheyeTexture );
+}
+
+void FisheyeConverterGL::setShader()
+{
+   const std::string shader_path = std::string(CMAKE_SOURCE_DIR) + "/shaders/FisheyeToLongitudeLatitude.comp";
+   ConverterShader = std::make_unique<ShaderGL>();
+   ConverterShader->setComputeShaders( { shader_path.c_str() } );
+   ConverterShader->addUniformLocationToComputeShader( "LensModel", 0 );
+   ConverterShader->addUniformLocationToComputeShader( "LensCoefficients", 0 );
+   ConverterShader->addUniformLocationToComputeShader( "RadiusScale", 0 );
+   ConverterShader->addUniformLocationToComputeShader( "OpticalCenter", 0 );
+   ConverterShader->addUniformLocationToComputeShader( "ImageCircleRadius", 0 );
+}
+
+void FisheyeConverterGL::uploadFisheye(const cv::Mat& fisheye)
+// The storage is kept while the size stays the same, so converting the frames of a video only uploads the pixels.
+{
+   if (FisheyeTexture == 0 || FisheyeSize != fisheye.size()) {
+      if (FisheyeTexture != 0) glDeleteTextures( 1, &FisheyeTexture );
+      glCreateTextures( GL_TEXTURE_2D, 1, &FisheyeTexture );
+      glTextureStorage2D( FisheyeTexture, 1, GL_RGBA8, fisheye.cols, fisheye.rows );
+      FisheyeSize = fisheye.size();
+   }
+   glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+   glPixelStorei( GL_UNPACK_ROW_LENGTH, static_cast<GLint>(fisheye.step / fisheye.elemSize()) );
+   glTextureSubImage2D( FisheyeTexture, 0, 0, 0, fisheye.cols, fisheye.rows, GL_BGR, GL_UNSIGNED_BYTE, fisheye.data );
+   glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+   glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+}
+
+TextureCacheGL::Handle FisheyeConverterGL::convert(const cv::Mat& fisheye)
+{
+   return convert( fisheye, EquidistantLens() );
+}
+
+TextureCacheGL::Handle FisheyeConverterGL::convert(const cv::Mat& fisheye, const LensParameters& parameters)
+{
+   if (fisheye.type() != CV_8UC3 || fisheye.cols < 2 || fisheye.rows < 2) {
+      std::cerr << "Only a BGR image of at least 2x2 can be converted on the GPU.\n";
+      return nullptr;
+   }
+   if (ConverterShader == nullptr) setShader();
+   uploadFisheye( fisheye );
+
+   GLuint texture_id = 0;
+   glCreateTextures( GL_TEXTURE_2D, 1, &texture_id );
+   glTextureStorage2D( texture_id, 1, GL_RGBA8, fisheye.cols, fisheye.rows );
+   glTextureParameteri( texture_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+   glTextureParameteri( texture_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_S, GL_REPEAT );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_T, GL_REPEAT );
+
+   glUseProgram( ConverterShader->getComputeShaderProgram( 0 ) );
+   glUniform1i( ConverterShader->getLocation( "LensModel" ), parameters.Model );
+   glUniform4fv( ConverterShader->getLocation( "LensCoefficients" ), 1, &parameters.Coefficients[0] );
+   glUniform1f( ConverterShader->getLocation( "RadiusScale" ), parameters.RadiusScale );
+   glUniform2fv( ConverterShader->getLocation( "OpticalCenter" ), 1, &parameters.OpticalCenter[0] );
+   glUniform2fv( ConverterShader->getLocation( "ImageCircleRadius" ), 1, &parameters.ImageCircleRadius[0] );
+   glBindTextureUnit( 0, FisheyeTexture );
+   glBindImageTexture( 0, texture_id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8 );
+   glDispatchCompute( (fisheye.cols + 15) / 16, (fisheye.rows + 15) / 16, 1 );
+   glMemoryBarrier( GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT );
+   glBindImageTexture( 0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8 );
+   glUseProgram( 0 );
+
+   return TextureCacheGL::Handle(
+      new GLuint(texture_id),
+      [](const GLuint* id) {
+         glDeleteTextures( 1, id );
+         delete id;
+      }
+   );
+}
+
+void FisheyeConverterGL::readTexture(cv::Mat& converted, GLuint texture_id)
+{
+   GLint width = 0, height = 0;
+   glGetTextureLevelParameteriv( texture_id, 0, GL_TEXTURE_WIDTH, &width );
+   glGetTextureLevelParameteriv( texture_id, 0, GL_TEXTURE_HEIGHT, &height );
+   converted.create( height, width, CV_8UC3 );
+   glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+   glGetTextureImage(
+      texture_id, 0, GL_BGR, GL_UNSIGNED_BYTE, static_cast<GLsizei>(converted.total() * converted.elemSize()),
+      converted.data
+   );
+   glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+}
+
+template<typename Lens>
+bool FisheyeConverterGL::compareWithCPU(
+   LongitudeLatitudeMapping& mapper,
+   const cv::Mat& fisheye,
+   const Lens& lens,
+   const std::string& lens_name,
+   int thread_num
+)
+// Both sides are timed after a warm-up, which builds the remap table on the CPU and compiles the shader on the GPU.
+// The GPU time includes the upload of the fisheye image, but not the readback which is only for the comparison.
+// At the rim of the image circle, a coordinate can round into the circle on one side and out of it on the other, so a
+// few pixels may differ by the full color there. Any larger share than 0.1% of the channels means the math disagrees.
+{
+   cv::Mat cpu_converted;
+   mapper.convertFisheye( cpu_converted, fisheye, lens, thread_num );
+   const auto cpu_start = std::chrono::steady_clock::now();
+   mapper.convertFisheye( cpu_converted, fisheye, lens, thread_num );
+   const double cpu_elapsed =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpu_start).count();
+
+   TextureCacheGL::Handle texture = convert( fisheye, lens );
+   if (texture == nullptr) return false;
+   glFinish();
+   const auto gpu_start = std::chrono::steady_clock::now();
+   texture = convert( fisheye, lens );
+   glFinish();
+   const double gpu_elapsed =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gpu_start).count();
+
+   cv::Mat gpu_converted, difference;
+   readTexture( gpu_converted, *texture );
+   cv::absdiff( cpu_converted, gpu_converted, difference );
+   difference = difference.reshape( 1 );
+   double max_difference = 0.0;
+   cv::minMaxLoc( difference, nullptr, &max_difference );
+   const double mean_difference = cv::mean( difference )[0];
+   const double off_ratio = static_cast<double>(cv::countNonZero( difference > 1 )) / difference.total();
+   const bool matched = off_ratio <= 1e-3;
+
+   std::cout << " - " << std::setw( 14 ) << std::left << lens_name << std::right << ": max " << max_difference
+      << ", mean " << std::fixed << std::setprecision( 4 ) << mean_difference << ", "
+      << off_ratio * 100.0 << "% of channels off by more than 1, CPU " << std::setprecision( 3 ) << cpu_elapsed
+      << " ms, GPU " << gpu_elapsed << " ms" << (matched ? "" : " (MISMATCHED)") << "\n";
+   std::cout.unsetf( std::ios::floatfield );
+   return matched;
+}
+
+bool FisheyeConverterGL::compareWithCPU(const cv::Mat& fisheye, int thread_num)
+{
+   if (fisheye.type() != CV_8UC3 || fisheye.cols < 2 || fisheye.rows < 2) {
+      std::cerr << "Only a BGR image of at least 2x2 can be converted on the GPU.\n";
+      return false;
+   }
+
+   LongitudeLatitudeMapping mapper;
+   bool matched = true;
+   std::cout << "****************************************************************\n";
+   std::cout << " - Fisheye Conversion: " << fisheye.cols << "x" << fisheye.rows << " on CPU and GPU\n";
+   matched &= compareWithCPU( mapper, fisheye, EquidistantLens(), "Equidistant", thread_num );
+   matched &= compareWithCPU( mapper, fisheye, EquisolidLens(), "Equisolid", thread_num );
+   matched &= compareWithCPU( mapper, fisheye, OrthographicLens(), "Orthographic", thread_num );
+   matched &= compareWithCPU( mapper, fisheye, StereographicLens(), "Stereographic", thread_num );
+   matched &= compareWithCPU(
+      mapper, fisheye, KannalaBrandtLens({ -0.02, 0.003, 0.0, 0.0 }, 190.0), "Kannala-Brandt", thread_num
+   );
+   std::cout << "****************************************************************\n\n";
+   return matched;
+}
\ No newline at end of file
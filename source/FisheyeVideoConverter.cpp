@@ -0,0 +1,136 @@
+#include "FisheyeVideoConverter.h"
+
+FisheyeVideoConverter::FisheyeVideoConverter(int thread_num, size_t queue_capacity) :
+   ThreadNum( thread_num ), QueueCapacity( queue_capacity )
+{
+   setLens( EquidistantLens() );
+}
+
+double FisheyeVideoConverter::getSecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+FisheyeVideoConverter::QueueReport FisheyeVideoConverter::getQueueReport(
+   const std::string& name,
+   const BoundedQueue<Frame>& queue
+)
+{
+   QueueReport report;
+   report.Name = name;
+   report.Capacity = queue.getCapacity();
+   report.MaxOccupancy = queue.getMaxOccupancy();
+   report.AverageOccupancy = queue.getAverageOccupancy();
+   return report;
+}
+
+bool FisheyeVideoConverter::convert(cv::VideoCapture& capture, const FrameSink& sink)
+{
+   if (!capture.isOpened()) {
+      std::cerr << "The video capture is not opened.\n";
+      return false;
+   }
+
+   LastReport = Report();
+   LastReport.Stages = { StageReport("decode"), StageReport("convert"), StageReport("encode") };
+   BoundedQueue<Frame> decoded(QueueCapacity);
+   BoundedQueue<Frame> converted(QueueCapacity);
+   bool sink_succeeded = true;
+
+   const auto start = std::chrono::steady_clock::now();
+   std::thread decoder([&]() {
+      StageReport& stage = LastReport.Stages[0];
+      for (int index = 0; ; ++index) {
+         const auto begin = std::chrono::steady_clock::now();
+         cv::Mat image;
+         if (!capture.read( image ) || image.empty()) break;
+         stage.BusySeconds += getSecondsSince( begin );
+         stage.FrameNum++;
+         if (!decoded.push( Frame(index, std::move( image )) )) break;
+      }
+      decoded.close();
+   });
+   std::thread converter([&]() {
+      StageReport& stage = LastReport.Stages[1];
+      Frame fisheye;
+      while (decoded.pop( fisheye )) {
+         const auto begin = std::chrono::steady_clock::now();
+         cv::Mat longitude_latitude;
+         Convert( longitude_latitude, fisheye.Image );
+         stage.BusySeconds += getSecondsSince( begin );
+         stage.FrameNum++;
+         if (!converted.push( Frame(fisheye.Index, std::move( longitude_latitude )) )) break;
+      }
+      decoded.close();
+      converted.close();
+   });
+
+   StageReport& stage = LastReport.Stages[2];
+   Frame longitude_latitude;
+   while (converted.pop( longitude_latitude )) {
+      const auto begin = std::chrono::steady_clock::now();
+      sink_succeeded = sink( longitude_latitude.Image, longitude_latitude.Index );
+      stage.BusySeconds += getSecondsSince( begin );
+      if (!sink_succeeded) break;
+      stage.FrameNum++;
+   }
+   converted.close();
+   decoded.close();
+   converter.join();
+   decoder.join();
+
+   LastReport.FrameNum = stage.FrameNum;
+   LastReport.TotalSeconds = getSecondsSince( start );
+   LastReport.Queues = { getQueueReport( "decoded", decoded ), getQueueReport( "converted", converted ) };
+   return sink_succeeded;
+}
+
+bool FisheyeVideoConverter::convert(const std::string& input_path, const std::string& output_path)
+{
+   cv::VideoCapture capture(input_path);
+   if (!capture.isOpened()) {
+      std::cerr << "Could not open video file " << input_path << "\n";
+      return false;
+   }
+
+   double fps = capture.get( cv::CAP_PROP_FPS );
+   if (fps <= 0.0) fps = 30.0;
+   cv::VideoWriter writer;
+   const bool succeeded = convert(
+      capture,
+      [&](const cv::Mat& converted, int) {
+         if (!writer.isOpened()) {
+            writer.open( output_path, cv::VideoWriter::fourcc( 'm', 'p', '4', 'v' ), fps, converted.size() );
+            if (!writer.isOpened()) {
+               std::cerr << "Could not open video file " << output_path << "\n";
+               return false;
+            }
+         }
+         writer.write( converted );
+         return true;
+      }
+   );
+   writer.release();
+   return succeeded;
+}
+
+void FisheyeVideoConverter::printReport() const
+{
+   const double total_fps = LastReport.TotalSeconds > 0.0 ? LastReport.FrameNum / LastReport.TotalSeconds : 0.0;
+   std::cout << "****************************************************************\n";
+   std::cout << " - Converted Frames: " << LastReport.FrameNum << " in " << std::fixed << std::setprecision( 3 )
+      << LastReport.TotalSeconds << " sec (" << std::setprecision( 2 ) << total_fps << " fps)\n";
+   for (const auto& stage : LastReport.Stages) {
+      const double fps = stage.BusySeconds > 0.0 ? stage.FrameNum / stage.BusySeconds : 0.0;
+      std::cout << " - Stage " << std::setw( 8 ) << std::left << stage.Name << std::right << ": "
+         << stage.FrameNum << " frames, busy " << std::setprecision( 3 ) << stage.BusySeconds << " sec ("
+         << std::setprecision( 2 ) << fps << " fps alone)\n";
+   }
+   for (const auto& queue : LastReport.Queues) {
+      std::cout << " - Queue " << std::setw( 9 ) << std::left << queue.Name << std::right << ": average "
+         << std::setprecision( 2 ) << queue.AverageOccupancy << ", max " << queue.MaxOccupancy
+         << " of " << queue.Capacity << "\n";
+   }
+   std::cout << "****************************************************************\n\n";
+   std::cout.unsetf( std::ios::floatfield );
+}
\ No newline at end of file
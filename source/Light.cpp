@@ -1,10 +1,16 @@
 #include "Light.h"
 
 LightGL::LightGL() :
-   TurnLightOn( true ), GlobalAmbientColor( 0.2f, 0.2f, 0.2f, 1.0f ), TotalLightNum( 0 )
+   TurnLightOn( true ), IsDirty( true ), TotalLightNum( 0 ), LightBuffer( 0 ), LightBufferSize( 0 ), ViewMatrix( 1.0f ),
+   GlobalAmbientColor( 0.2f, 0.2f, 0.2f, 1.0f )
 {
 }
 
+LightGL::~LightGL()
+{
+   if (LightBuffer != 0) glDeleteBuffers( 1, &LightBuffer );
+}
+
 bool LightGL::isLightOn() const
 {
    return TurnLightOn;
@@ -13,6 +19,7 @@ bool LightGL::isLightOn() const
 void LightGL::toggleLightSwitch()
 {
    TurnLightOn = !TurnLightOn;
+   IsDirty = true;
 }
 
 void LightGL::addLight(
@@ -40,35 +47,75 @@ void LightGL::addLight(
    IsActivated.emplace_back( true );
 
    TotalLightNum = static_cast<int>(Positions.size());
+   IsDirty = true;
 }
 
 void LightGL::activateLight(const int& light_index)
 {
    if (light_index >= TotalLightNum) return;
    IsActivated[light_index] = true;
+   IsDirty = true;
 }
 
 void LightGL::deactivateLight(const int& light_index)
 {
    if (light_index >= TotalLightNum) return;
    IsActivated[light_index] = false;
+   IsDirty = true;
+}
+
+void LightGL::setLightPosition(int light_index, const glm::vec4& light_position)
+{
+   if (light_index >= TotalLightNum) return;
+   Positions[light_index] = light_position;
+   IsDirty = true;
 }
 
-void LightGL::transferUniformsToShader(const ShaderGL* shader)
+void LightGL::uploadLightBuffer(const glm::mat4& view_matrix)
+// The lights switched off after the last activated one are left out of LightNum, so the shader does not loop over them.
 {
-   glUniform1i( shader->getLightAvailabilityLocation(), TurnLightOn ? 1 : 0 );
-   glUniform1i( shader->getLightNumLocation(), static_cast<GLint>(TotalLightNum) );
-   glUniform4fv( shader->getGlobalAmbientLocation(), 1, &GlobalAmbientColor[0] );
+   int shaded_light_num = TotalLightNum;
+   while (shaded_light_num > 0 && !IsActivated[shaded_light_num - 1]) shaded_light_num--;
 
+   LightBufferHeader header{};
+   header.GlobalAmbient = GlobalAmbientColor;
+   header.UseLight = TurnLightOn ? 1 : 0;
+   header.LightNum = shaded_light_num;
+
+   const glm::mat3 view_normal_matrix = glm::transpose( glm::inverse( glm::mat3(view_matrix) ) );
+   std::vector<LightInfo> lights(TotalLightNum);
    for (int i = 0; i < TotalLightNum; ++i) {
-      glUniform1i( shader->getLightSwitchLocation( i ), IsActivated[0] ? 1 : 0 );
-      glUniform4fv( shader->getLightPositionLocation( i ), 1, &Positions[i][0] );
-      glUniform4fv( shader->getLightAmbientLocation( i ), 1, &AmbientColors[i][0] );
-      glUniform4fv( shader->getLightDiffuseLocation( i ), 1, &DiffuseColors[i][0] );
-      glUniform4fv( shader->getLightSpecularLocation( i ), 1, &SpecularColors[i][0] );
-      glUniform3fv( shader->getLightSpotlightDirectionLocation( i ), 1, &SpotlightDirections[i][0] );
-      glUniform1f( shader->getLightSpotlightCutoffAngleLocation( i ), SpotlightCutoffAngles[i] );
-      glUniform1f( shader->getLightSpotlightFeatherLocation( i ), SpotlightFeathers[i] );
-      glUniform1f( shader->getLightFallOffRadiusLocation( i ), FallOffRadii[i] );
+      lights[i].PositionInEC = view_matrix * Positions[i];
+      lights[i].AmbientColor = AmbientColors[i];
+      lights[i].DiffuseColor = DiffuseColors[i];
+      lights[i].SpecularColor = SpecularColors[i];
+      lights[i].SpotlightDirectionInEC = glm::normalize( view_normal_matrix * SpotlightDirections[i] );
+      lights[i].SpotlightCutoffAngle = SpotlightCutoffAngles[i];
+      lights[i].SpotlightFeather = SpotlightFeathers[i];
+      lights[i].FallOffRadius = FallOffRadii[i];
+      lights[i].LightSwitch = IsActivated[i] ? 1 : 0;
+      lights[i].Padding = 0;
+   }
+
+   // The storage is immutable, so it is created again only when the lights do not fit in it.
+   const auto lights_size = static_cast<GLsizeiptr>(sizeof( LightInfo ) * lights.size());
+   const auto buffer_size = static_cast<GLsizeiptr>(sizeof( LightBufferHeader )) + lights_size;
+   if (LightBuffer == 0 || LightBufferSize < buffer_size) {
+      if (LightBuffer != 0) glDeleteBuffers( 1, &LightBuffer );
+      glCreateBuffers( 1, &LightBuffer );
+      glNamedBufferStorage( LightBuffer, buffer_size, nullptr, GL_DYNAMIC_STORAGE_BIT );
+      LightBufferSize = buffer_size;
+   }
+   glNamedBufferSubData( LightBuffer, 0, sizeof( LightBufferHeader ), &header );
+   if (lights_size > 0) {
+      glNamedBufferSubData( LightBuffer, sizeof( LightBufferHeader ), lights_size, lights.data() );
    }
+   ViewMatrix = view_matrix;
+   IsDirty = false;
+}
+
+void LightGL::bindLightBuffer(const glm::mat4& view_matrix)
+{
+   if (IsDirty || view_matrix != ViewMatrix) uploadLightBuffer( view_matrix );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, LightBufferBinding, LightBuffer );
 }
\ No newline at end of file
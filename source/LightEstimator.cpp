@@ -0,0 +1,229 @@
+#include "LightEstimator.h"
+
+LightEstimatorGL::LightEstimatorGL() :
+   IntegralBuffer( 0 ), RowWeightBuffer( 0 ), RegionBuffer( 0 ), RegionCapacity( 0 ), ReadbackBytes( 0 )
+{
+   static_assert( sizeof( Region ) == 32, "Region should follow the std430 layout of MedianCut.comp." );
+}
+
+LightEstimatorGL::~LightEstimatorGL()
+{
+   if (IntegralBuffer != 0) glDeleteBuffers( 1, &IntegralBuffer );
+   if (RowWeightBuffer != 0) glDeleteBuffers( 1, &RowWeightBuffer );
+   if (RegionBuffer != 0) glDeleteBuffers( 1, &RegionBuffer );
+}
+
+void LightEstimatorGL::setShader()
+{
+   const std::string shader_directory_path = std::string(CMAKE_SOURCE_DIR) + "/shaders";
+   const std::string integral_shader_path = shader_directory_path + "/IntensityIntegral.comp";
+   const std::string median_cut_shader_path = shader_directory_path + "/MedianCut.comp";
+   EstimatorShader = std::make_unique<ShaderGL>();
+   EstimatorShader->setComputeShaders( { integral_shader_path.c_str(), median_cut_shader_path.c_str() } );
+   EstimatorShader->addUniformLocationToComputeShader( "ScanColumns", 0 );
+   EstimatorShader->addUniformLocationToComputeShader( "ImageSize", 1 );
+   EstimatorShader->addUniformLocationToComputeShader( "LightNumToFind", 1 );
+   EstimatorShader->addUniformLocationToComputeShader( "Iteration", 1 );
+   EstimatorShader->addUniformLocationToComputeShader( "UseAdaptiveCut", 1 );
+}
+
+void LightEstimatorGL::prepareBuffers(const cv::Size& image_size, int region_num)
+// The first row and column of the table are never written by the scans, so they are cleared only when it is created.
+// The row weights are computed on the CPU as LightPosition::adjustIntensities(), so both sides get the same floats.
+{
+   if (ImageSize != image_size) {
+      if (IntegralBuffer != 0) glDeleteBuffers( 1, &IntegralBuffer );
+      if (RowWeightBuffer != 0) glDeleteBuffers( 1, &RowWeightBuffer );
+
+      const auto integral_size =
+         static_cast<GLsizeiptr>(image_size.width + 1) * (image_size.height + 1) * static_cast<GLsizeiptr>(sizeof( double ));
+      glCreateBuffers( 1, &IntegralBuffer );
+      glNamedBufferStorage( IntegralBuffer, integral_size, nullptr, 0 );
+      glClearNamedBufferData( IntegralBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr );
+
+      std::vector<float> row_weights(image_size.height);
+      const double scale = 1.0 / static_cast<double>(image_size.height - 1);
+      for (int j = 0; j < image_size.height; ++j) {
+         row_weights[j] = static_cast<float>(sin( static_cast<double>(j) * scale * CV_PI ));
+      }
+      glCreateBuffers( 1, &RowWeightBuffer );
+      glNamedBufferStorage(
+         RowWeightBuffer, static_cast<GLsizeiptr>(row_weights.size() * sizeof( float )), row_weights.data(), 0
+      );
+      ImageSize = image_size;
+   }
+
+   if (RegionCapacity < region_num) {
+      if (RegionBuffer != 0) glDeleteBuffers( 1, &RegionBuffer );
+      glCreateBuffers( 1, &RegionBuffer );
+      glNamedBufferStorage( RegionBuffer, static_cast<GLsizeiptr>(region_num * sizeof( Region )), nullptr, 0 );
+      RegionCapacity = region_num;
+   }
+}
+
+void LightEstimatorGL::buildIntensityIntegral(GLuint longitude_latitude_texture)
+{
+   glUseProgram( EstimatorShader->getComputeShaderProgram( 0 ) );
+   glBindTextureUnit( 0, longitude_latitude_texture );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, IntegralBuffer );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, RowWeightBuffer );
+
+   glUniform1i( EstimatorShader->getLocation( "ScanColumns" ), 0 );
+   glDispatchCompute( ImageSize.height, 1, 1 );
+   glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+   glUniform1i( EstimatorShader->getLocation( "ScanColumns" ), 1 );
+   glDispatchCompute( ImageSize.width, 1, 1 );
+   glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+}
+
+bool LightEstimatorGL::estimateLightPositions(
+   std::vector<LightPosition::LightInfo>& lights,
+   GLuint longitude_latitude_texture,
+   int light_num_to_find,
+   LightPosition::ALGORITHM algorithm
+)
+{
+   lights.clear();
+   ReadbackBytes = 0;
+   if (algorithm != LightPosition::ALGORITHM::MEDIAN_CUT && algorithm != LightPosition::ALGORITHM::ADAPTIVE_MEDIAN_CUT) {
+      std::cerr << "Only the median cuts can find the lights on the GPU.\n";
+      return false;
+   }
+   if (light_num_to_find <= 0) return true;
+
+   GLint width = 0, height = 0;
+   glGetTextureLevelParameteriv( longitude_latitude_texture, 0, GL_TEXTURE_WIDTH, &width );
+   glGetTextureLevelParameteriv( longitude_latitude_texture, 0, GL_TEXTURE_HEIGHT, &height );
+   if (width < 2 || height < 2) {
+      std::cerr << "The lights can be found on the GPU only in a texture of at least 2x2.\n";
+      return false;
+   }
+   if (EstimatorShader == nullptr) setShader();
+
+   int iteration = 0;
+   while ((1 << iteration) < light_num_to_find) iteration++;
+   const bool use_adaptive_cut = algorithm == LightPosition::ALGORITHM::ADAPTIVE_MEDIAN_CUT;
+   const int region_num = use_adaptive_cut ? light_num_to_find : 1 << iteration;
+   const auto region_bytes = static_cast<GLsizeiptr>(region_num * sizeof( Region ));
+   prepareBuffers( { width, height }, region_num );
+   buildIntensityIntegral( longitude_latitude_texture );
+
+   glClearNamedBufferSubData( RegionBuffer, GL_R32UI, 0, region_bytes, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr );
+   glUseProgram( EstimatorShader->getComputeShaderProgram( 1 ) );
+   glUniform2i( EstimatorShader->getLocation( "ImageSize" ), width, height );
+   glUniform1i( EstimatorShader->getLocation( "LightNumToFind" ), light_num_to_find );
+   glUniform1i( EstimatorShader->getLocation( "Iteration" ), iteration );
+   glUniform1i( EstimatorShader->getLocation( "UseAdaptiveCut" ), use_adaptive_cut ? 1 : 0 );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, IntegralBuffer );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, RegionBuffer );
+   glDispatchCompute( 1, 1, 1 );
+   glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+   glUseProgram( 0 );
+
+   std::vector<Region> regions(region_num);
+   glGetNamedBufferSubData( RegionBuffer, 0, region_bytes, regions.data() );
+   ReadbackBytes = static_cast<size_t>(region_bytes);
+
+   for (const auto& region : regions) {
+      if (region.Block.z == 0) continue;
+
+      LightPosition::LightInfo light;
+      light.Position = cv::Point(region.Center.x, region.Center.y);
+      light.Block = cv::Rect(region.Block.x, region.Block.y, region.Block.z, region.Block.w);
+      light.Intensity = static_cast<float>(region.Intensity);
+      lights.emplace_back( light );
+   }
+   std::stable_sort(
+      lights.begin(), lights.end(),
+      [](const LightPosition::LightInfo& a, const LightPosition::LightInfo& b) { return a.Intensity > b.Intensity; }
+   );
+   if (static_cast<int>(lights.size()) > light_num_to_find) lights.resize( light_num_to_find );
+   return true;
+}
+
+int LightEstimatorGL::getMismatchedLightNum(
+   std::vector<LightPosition::LightInfo> cpu_lights,
+   std::vector<LightPosition::LightInfo> gpu_lights
+)
+// The intensities are summed in another order on the GPU, so they are compared within a relative error of the doubles.
+{
+   const auto by_block = [](const LightPosition::LightInfo& a, const LightPosition::LightInfo& b) {
+      return std::make_tuple( a.Block.y, a.Block.x, a.Block.height, a.Block.width ) <
+         std::make_tuple( b.Block.y, b.Block.x, b.Block.height, b.Block.width );
+   };
+   std::sort( cpu_lights.begin(), cpu_lights.end(), by_block );
+   std::sort( gpu_lights.begin(), gpu_lights.end(), by_block );
+
+   const size_t common_num = std::min( cpu_lights.size(), gpu_lights.size() );
+   int mismatched_num = static_cast<int>(std::max( cpu_lights.size(), gpu_lights.size() ) - common_num);
+   for (size_t i = 0; i < common_num; ++i) {
+      const LightPosition::LightInfo& cpu = cpu_lights[i];
+      const LightPosition::LightInfo& gpu = gpu_lights[i];
+      const float tolerance = 1e-5f * std::max( std::abs( cpu.Intensity ), 1.0f );
+      if (cpu.Block != gpu.Block || cpu.Position != gpu.Position || std::abs( cpu.Intensity - gpu.Intensity ) > tolerance) {
+         mismatched_num++;
+      }
+   }
+   return mismatched_num;
+}
+
+bool LightEstimatorGL::compareWithCPU(const cv::Mat& longitude_latitude)
+// Each side is timed for the whole estimation from the image, and the GPU is warmed up once to compile the shaders.
+{
+   struct Comparison
+   {
+      std::string Name;
+      int LightNumToFind;
+      size_t LightNum;
+      int MismatchedNum;
+      double CPUTime;
+      double GPUTime;
+      size_t ReadbackBytes;
+   };
+
+   TextureCacheGL texture_cache;
+   const TextureCacheGL::Handle texture = texture_cache.getTexture( longitude_latitude );
+   std::vector<LightPosition::LightInfo> cpu_lights, gpu_lights;
+   if (texture == nullptr || !estimateLightPositions( gpu_lights, *texture, 1 )) return false;
+
+   LightPosition cpu_finder;
+   std::vector<Comparison> comparisons;
+   for (const auto algorithm : { LightPosition::ALGORITHM::MEDIAN_CUT, LightPosition::ALGORITHM::ADAPTIVE_MEDIAN_CUT }) {
+      for (const int light_num_to_find : { 1, 5, 16, 64, 256 }) {
+         Comparison comparison;
+         comparison.Name = algorithm == LightPosition::ALGORITHM::MEDIAN_CUT ? "Median Cut" : "Adaptive Median Cut";
+         comparison.LightNumToFind = light_num_to_find;
+
+         const auto cpu_start = std::chrono::steady_clock::now();
+         cpu_finder.estimateLightPositions( cpu_lights, longitude_latitude, light_num_to_find, algorithm );
+         comparison.CPUTime =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpu_start).count();
+
+         const auto gpu_start = std::chrono::steady_clock::now();
+         if (!estimateLightPositions( gpu_lights, *texture, light_num_to_find, algorithm )) return false;
+         comparison.GPUTime =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gpu_start).count();
+
+         comparison.LightNum = cpu_lights.size();
+         comparison.MismatchedNum = getMismatchedLightNum( cpu_lights, gpu_lights );
+         comparison.ReadbackBytes = ReadbackBytes;
+         comparisons.emplace_back( comparison );
+      }
+   }
+
+   bool matched = true;
+   std::cout << "****************************************************************\n";
+   std::cout << " - Light Estimation: " << longitude_latitude.cols << "x" << longitude_latitude.rows
+      << " on CPU and GPU\n";
+   for (const auto& comparison : comparisons) {
+      matched &= comparison.MismatchedNum == 0;
+      std::cout << " - " << std::setw( 19 ) << std::left << comparison.Name << std::right << " x "
+         << std::setw( 3 ) << comparison.LightNumToFind << ": " << comparison.MismatchedNum << " of "
+         << comparison.LightNum << " lights mismatched, CPU " << std::fixed << std::setprecision( 3 )
+         << comparison.CPUTime << " ms, GPU " << comparison.GPUTime << " ms, " << comparison.ReadbackBytes
+         << " bytes read back\n";
+      std::cout.unsetf( std::ios::floatfield );
+   }
+   std::cout << "****************************************************************\n\n";
+   return matched;
+}
\ No newline at end of file
@@ -16,14 +16,24 @@ int LightPosition::getNextHighestPowerOf2(int number)
    return static_cast<int>(value + 1);
 }
 
-void LightPosition::drawLightPosition(cv::Mat& image, const cv::Point& light_position)
+void LightPosition::drawLightPositions(cv::Mat& image, const std::vector<LightInfo>& lights)
+// The blocks tile the image, so drawing their outlines shows the whole partition. It draws only on the given image.
 {
-   cv::circle( image, light_position, 3, cv::Scalar(0, 255, 255), -1 );
+   for (const auto& light : lights) {
+      cv::rectangle( image, light.Block, cv::Scalar(0, 255, 0), 1 );
+   }
+   for (const auto& light : lights) {
+      cv::circle( image, light.Position, 3, cv::Scalar(0, 255, 255), -1 );
+   }
 }
 
-void LightPosition::drawBlockLine(cv::Mat& image, const cv::Point& start, const cv::Point& end)
+void LightPosition::addLight(const cv::Point& light_position, const cv::Rect& block)
 {
-   cv::line( image, start, end, cv::Scalar(0, 255, 0), 1 );
+   LightInfo light;
+   light.Position = light_position;
+   light.Block = block;
+   light.Intensity = static_cast<float>(getIntensitySum( block ));
+   Lights.emplace_back( light );
 }
 
 void LightPosition::adjustIntensities(const cv::Mat& longitude_latitude)
@@ -41,133 +51,145 @@ void LightPosition::adjustIntensities(const cv::Mat& longitude_latitude)
          adjusted_ptr[i] = adjuster * static_cast<float>(gray_ptr[i]);
       }
    }
+   cv::integral( AdjustedIntensities, IntensityIntegral, CV_64F );
 }
 
-void LightPosition::calculateDeltaXDividingIntensityInHalf(
-   int& dx,
-   const cv::Mat& adjusted, 
-   const cv::Range& row_range,
-   float half_intensity
-)
+void LightPosition::buildMomentIntegrals()
+// The channels are the intensity-weighted moments I * x, I * y and I * (x^2 + y^2), so the variance of any block about
+// any center is read from the tables in O(1).
 {
-   float half_sum_from_x = 0.0f;
-   while (half_sum_from_x < half_intensity && dx < adjusted.cols) {
-      dx++;
-      for (int j = row_range.start; j < row_range.end; ++j) {
-         half_sum_from_x += adjusted.at<float>(j, dx);
+   cv::Mat moments(AdjustedIntensities.size(), CV_64FC3);
+   for (int j = 0; j < AdjustedIntensities.rows; ++j) {
+      const auto* adjusted_ptr = AdjustedIntensities.ptr<float>(j);
+      auto* moments_ptr = moments.ptr<cv::Vec3d>(j);
+      for (int i = 0; i < AdjustedIntensities.cols; ++i) {
+         const auto intensity = static_cast<double>(adjusted_ptr[i]);
+         moments_ptr[i][0] = intensity * i;
+         moments_ptr[i][1] = intensity * j;
+         moments_ptr[i][2] = intensity * (static_cast<double>(i) * i + static_cast<double>(j) * j);
       }
    }
+   cv::integral( moments, MomentIntegrals, CV_64F );
 }
 
-void LightPosition::calculateDeltaYDividingIntensityInHalf(
-   int& dy,
-   const cv::Mat& adjusted, 
-   const cv::Range& col_range,
-   float half_intensity
-)
+double LightPosition::getIntensitySum(const cv::Rect& region) const
+// IntensityIntegral(y, x) is the sum of the adjusted intensities in [0, x) x [0, y), so any region sum needs only four
+// lookups instead of a scan of the region.
 {
-   float half_sum_from_y = 0.0f;
-   while (half_sum_from_y < half_intensity && dy < adjusted.rows) {
-      dy++;
-      const auto* adjusted_ptr = adjusted.ptr<float>(dy);
-      for (int i = col_range.start; i < col_range.end; ++i) {
-         half_sum_from_y += adjusted_ptr[i];
-      }
+   const auto* top_ptr = IntensityIntegral.ptr<double>(region.y);
+   const auto* bottom_ptr = IntensityIntegral.ptr<double>(region.y + region.height);
+   return bottom_ptr[region.x + region.width] - bottom_ptr[region.x] - top_ptr[region.x + region.width] + top_ptr[region.x];
+}
+
+void LightPosition::calculateDeltaXDividingIntensityInHalf(int& dx, const cv::Rect& block, double half_intensity) const
+// dx is the smallest column offset in the block where the sum of the columns in [0, dx] reaches half_intensity.
+// The intensities are not negative, so the sums grow with dx and the offset is found by a binary search.
+{
+   int low = 0, high = block.width - 1;
+   while (low < high) {
+      const int middle = (low + high) / 2;
+      if (getIntensitySum( { block.x, block.y, middle + 1, block.height } ) < half_intensity) low = middle + 1;
+      else high = middle;
+   }
+   dx = low;
+}
+
+void LightPosition::calculateDeltaYDividingIntensityInHalf(int& dy, const cv::Rect& block, double half_intensity) const
+{
+   int low = 0, high = block.height - 1;
+   while (low < high) {
+      const int middle = (low + high) / 2;
+      if (getIntensitySum( { block.x, block.y, block.width, middle + 1 } ) < half_intensity) low = middle + 1;
+      else high = middle;
    }
+   dy = low;
 }
 
-void LightPosition::medianCut(cv::Mat& longitude_latitude, const cv::Rect& block, int iteration)
+void LightPosition::medianCut(const cv::Rect& block, int iteration)
 {
-   if (block.x >= longitude_latitude.cols || block.y >= longitude_latitude.rows || block.width == 0 || block.height == 0) return;
+   if (block.x >= AdjustedIntensities.cols || block.y >= AdjustedIntensities.rows || block.width == 0 || block.height == 0) return;
 
    int dx = -1, dy = -1;
-   const cv::Mat adjusted_block = AdjustedIntensities(block);
-   const float half_intensity = static_cast<float>(cv::sum( adjusted_block )[0]) * 0.5f;
+   const double half_intensity = getIntensitySum( block ) * 0.5;
 
    if (iteration == 0) {
-      calculateDeltaXDividingIntensityInHalf( dx, adjusted_block, { 0, adjusted_block.rows }, half_intensity );
-      calculateDeltaYDividingIntensityInHalf( dy, adjusted_block, { 0, adjusted_block.cols }, half_intensity );
+      calculateDeltaXDividingIntensityInHalf( dx, block, half_intensity );
+      calculateDeltaYDividingIntensityInHalf( dy, block, half_intensity );
 
-      const cv::Point light_position(block.x + dx, block.y + dy);
-      const float intensity = AdjustedIntensities.at<float>(light_position.y, light_position.x);
-      LightInfos[intensity] = light_position;
-      drawLightPosition( longitude_latitude, light_position );
+      addLight( { block.x + dx, block.y + dy }, block );
    }
    else if (block.width > block.height) {
-      calculateDeltaXDividingIntensityInHalf( dx, adjusted_block, { 0, adjusted_block.rows }, half_intensity );
-      drawBlockLine( longitude_latitude, { dx, block.tl().y }, { dx, block.br().y } );
-      
+      calculateDeltaXDividingIntensityInHalf( dx, block, half_intensity );
+
       const cv::Rect left_block(block.x, block.y, dx, block.height);
       const cv::Rect right_block(block.x + dx, block.y, block.width - dx, block.height);
-      medianCut( longitude_latitude, left_block, iteration - 1 );
-      medianCut( longitude_latitude, right_block, iteration - 1 );
+      medianCut( left_block, iteration - 1 );
+      medianCut( right_block, iteration - 1 );
    }
    else {
-      calculateDeltaYDividingIntensityInHalf( dy, adjusted_block, { 0, adjusted_block.cols }, half_intensity );
-      drawBlockLine( longitude_latitude, { block.tl().x, dy }, { block.br().x, dy } );
+      calculateDeltaYDividingIntensityInHalf( dy, block, half_intensity );
 
       const cv::Rect top_block(block.x, block.y, block.width, dy);
       const cv::Rect bottom_block(block.x, block.y + dy, block.width, block.height - dy);
-      medianCut( longitude_latitude, top_block, iteration - 1 );
-      medianCut( longitude_latitude, bottom_block, iteration - 1 );
+      medianCut( top_block, iteration - 1 );
+      medianCut( bottom_block, iteration - 1 );
    }
 }
 
-float LightPosition::calculateVariance(
-   const cv::Mat& adjusted, 
-   const cv::Point& center, 
-   const cv::Range& col_range, 
-   const cv::Range& row_range
-)
+cv::Vec3d LightPosition::getMomentSums(const cv::Rect& region) const
 {
-   float variance = 0.0f;
-   for (int j = row_range.start; j < row_range.end; ++j) {
-      const auto* adjusted_ptr = adjusted.ptr<float>(j);
-      for (int i = col_range.start; i < col_range.end; ++i) {
-         variance +=
-            adjusted_ptr[i] * static_cast<float>((i - center.x) * (i - center.x) + (j - center.y) * (j - center.y));
-      }
-   }
-   return sqrt( variance / static_cast<float>(col_range.size() * row_range.size()) );
+   const auto* top_ptr = MomentIntegrals.ptr<cv::Vec3d>(region.y);
+   const auto* bottom_ptr = MomentIntegrals.ptr<cv::Vec3d>(region.y + region.height);
+   return bottom_ptr[region.x + region.width] - bottom_ptr[region.x] - top_ptr[region.x + region.width] + top_ptr[region.x];
+}
+
+float LightPosition::calculateVariance(const cv::Rect& block, const cv::Point& center) const
+// sum(I * |p - c|^2) = sum(I * |p|^2) - 2 * dot(c, sum(I * p)) + |c|^2 * sum(I)
+{
+   const double intensity = getIntensitySum( block );
+   const cv::Vec3d moments = getMomentSums( block );
+   const double cx = center.x, cy = center.y;
+   const double variance = moments[2] - 2.0 * (cx * moments[0] + cy * moments[1]) + (cx * cx + cy * cy) * intensity;
+   return static_cast<float>(sqrt( std::max( variance, 0.0 ) / static_cast<double>(block.area()) ));
 }
 
 void LightPosition::calculateDeltaXMinimizingVariance(
    int& dx,
    cv::Point& left_prev_point,
    cv::Point& right_prev_point,
-   const cv::Mat& adjusted, 
-   float total_intensity
-)
+   const cv::Rect& block,
+   double total_intensity
+) const
+// The block is split into [0, dx] and [dx + 1, width) so that the larger variance of the two is the smallest.
+// The previous points are the median points of the two blocks, which become the light positions at the last iteration.
 {
-   float left_total = 0.0f;
    float min_of_max_variance = std::numeric_limits<float>::max();
-   for (int x = 0; x < adjusted.cols - 1; ++x) {
-      for (int j = 0; j < adjusted.rows; ++j) {
-         left_total += adjusted.at<float>(j, x);
-      }
+   for (int x = 0; x < block.width - 1; ++x) {
+      const cv::Rect left_block(block.x, block.y, x + 1, block.height);
+      const double left_total = getIntensitySum( left_block );
+      const double left_half_intensity = left_total * 0.5;
+
+      int left_dx, left_dy;
+      calculateDeltaXDividingIntensityInHalf( left_dx, left_block, left_half_intensity );
+      calculateDeltaYDividingIntensityInHalf( left_dy, left_block, left_half_intensity );
+      const cv::Point left_center(left_block.x + left_dx, left_block.y + left_dy);
+      const float max_left_variance = calculateVariance( left_block, left_center );
 
-      int left_dx = -1, left_dy = -1;
-      const cv::Range left_col_range(0, x + 1);
-      const cv::Range left_row_range(0, adjusted.rows);
-      const float left_half_intensity = left_total * 0.5f;
-      calculateDeltaXDividingIntensityInHalf( left_dx, adjusted, left_row_range, left_half_intensity );
-      calculateDeltaYDividingIntensityInHalf( left_dy, adjusted, left_col_range, left_half_intensity );
-      const float max_left_variance = calculateVariance( adjusted, { left_dx, left_dy }, left_col_range, left_row_range );
-
-      int right_dx = x, right_dy = -1;
-      const cv::Range right_col_range(x + 1, adjusted.cols);
-      const cv::Range right_row_range(0, adjusted.rows);
-      const float right_half_intensity = (total_intensity - left_total) * 0.5f;
-      calculateDeltaXDividingIntensityInHalf( right_dx, adjusted, right_row_range, right_half_intensity );
-      calculateDeltaYDividingIntensityInHalf( right_dy, adjusted, right_col_range, right_half_intensity );
-      const float max_right_variance = calculateVariance( adjusted, { right_dx, right_dy }, right_col_range, right_row_range );
+      const cv::Rect right_block(block.x + x + 1, block.y, block.width - x - 1, block.height);
+      const double right_half_intensity = (total_intensity - left_total) * 0.5;
+
+      int right_dx, right_dy;
+      calculateDeltaXDividingIntensityInHalf( right_dx, right_block, right_half_intensity );
+      calculateDeltaYDividingIntensityInHalf( right_dy, right_block, right_half_intensity );
+      const cv::Point right_center(right_block.x + right_dx, right_block.y + right_dy);
+      const float max_right_variance = calculateVariance( right_block, right_center );
 
       const float max_variance = std::max( max_left_variance, max_right_variance );
       if (min_of_max_variance > max_variance) {
          min_of_max_variance = max_variance;
          dx = x;
-         left_prev_point = { left_dx, right_dx };
-         right_prev_point = { right_dx, right_dy };
+         left_prev_point = left_center;
+         right_prev_point = right_center;
       }
    }
 }
@@ -176,108 +198,201 @@ void LightPosition::calculateDeltaYMinimizingVariance(
    int& dy,
    cv::Point& top_prev_point,
    cv::Point& bottom_prev_point,
-   const cv::Mat& adjusted, 
-   float total_intensity
-)
+   const cv::Rect& block,
+   double total_intensity
+) const
 {
-   float top_total = 0.0f;
    float min_of_max_variance = std::numeric_limits<float>::max();
-   for (int y = 0; y < adjusted.rows - 1; ++y) {
-      const auto* adjusted_ptr = adjusted.ptr<float>(y);
-      for (int i = 0; i < adjusted.cols; ++i) {
-         top_total += adjusted_ptr[i];
-      }
+   for (int y = 0; y < block.height - 1; ++y) {
+      const cv::Rect top_block(block.x, block.y, block.width, y + 1);
+      const double top_total = getIntensitySum( top_block );
+      const double top_half_intensity = top_total * 0.5;
 
-      int top_dx = -1, top_dy = -1;
-      const cv::Range top_col_range(0, adjusted.cols);
-      const cv::Range top_row_range(0, y + 1);
-      const float top_half_intensity = top_total * 0.5f;
-      calculateDeltaXDividingIntensityInHalf( top_dx, adjusted, top_row_range, top_half_intensity );
-      calculateDeltaYDividingIntensityInHalf( top_dy, adjusted, top_col_range, top_half_intensity );
-      const float max_left_variance = calculateVariance( adjusted, { top_dx, top_dy }, top_col_range, top_row_range );
-
-      int bottom_dx = -1, bottom_dy = y;
-      const cv::Range bottom_col_range(0, adjusted.cols);
-      const cv::Range bottom_row_range(y + 1, adjusted.rows);
-      const float bottom_half_intensity = (total_intensity - top_total) * 0.5f;
-      calculateDeltaXDividingIntensityInHalf( bottom_dx, adjusted, bottom_row_range, bottom_half_intensity );
-      calculateDeltaYDividingIntensityInHalf( bottom_dy, adjusted, bottom_col_range, bottom_half_intensity );
-      const float max_right_variance = calculateVariance( adjusted, { bottom_dx, bottom_dy }, bottom_col_range, bottom_row_range );
+      int top_dx, top_dy;
+      calculateDeltaXDividingIntensityInHalf( top_dx, top_block, top_half_intensity );
+      calculateDeltaYDividingIntensityInHalf( top_dy, top_block, top_half_intensity );
+      const cv::Point top_center(top_block.x + top_dx, top_block.y + top_dy);
+      const float max_top_variance = calculateVariance( top_block, top_center );
 
-      const float max_variance = std::max( max_left_variance, max_right_variance );
+      const cv::Rect bottom_block(block.x, block.y + y + 1, block.width, block.height - y - 1);
+      const double bottom_half_intensity = (total_intensity - top_total) * 0.5;
+
+      int bottom_dx, bottom_dy;
+      calculateDeltaXDividingIntensityInHalf( bottom_dx, bottom_block, bottom_half_intensity );
+      calculateDeltaYDividingIntensityInHalf( bottom_dy, bottom_block, bottom_half_intensity );
+      const cv::Point bottom_center(bottom_block.x + bottom_dx, bottom_block.y + bottom_dy);
+      const float max_bottom_variance = calculateVariance( bottom_block, bottom_center );
+
+      const float max_variance = std::max( max_top_variance, max_bottom_variance );
       if (min_of_max_variance > max_variance) {
          min_of_max_variance = max_variance;
          dy = y;
-         top_prev_point = { top_dx, top_dy };
-         bottom_prev_point = { bottom_dx, bottom_dy };
+         top_prev_point = top_center;
+         bottom_prev_point = bottom_center;
       }
    }
 }
 
-void LightPosition::varianceCut(cv::Mat& longitude_latitude, cv::Point& prev_point, const cv::Rect& block, int iteration)
+void LightPosition::varianceCut(const cv::Point& prev_point, const cv::Rect& block, int iteration)
+// prev_point is the median point of the block found while its parent was split, or negative for the whole image.
 {
-   if (block.x >= longitude_latitude.cols || block.y >= longitude_latitude.rows || block.width == 0 || block.height == 0) return;
+   if (block.x >= AdjustedIntensities.cols || block.y >= AdjustedIntensities.rows || block.width == 0 || block.height == 0) return;
 
-   int dx, dy;
-   cv::Point left_prev_point, right_prev_point;
-   cv::Point top_prev_point, bottom_prev_point;
-   const cv::Mat adjusted_block = AdjustedIntensities(block);
-   const float total_intensity = static_cast<float>(cv::sum( adjusted_block )[0]);
+   int dx = 0, dy = 0;
+   cv::Point left_prev_point(-1, -1), right_prev_point(-1, -1);
+   cv::Point top_prev_point(-1, -1), bottom_prev_point(-1, -1);
+   const double total_intensity = getIntensitySum( block );
 
    if (iteration == 0) {
-      if (prev_point.x == 0 || prev_point.y == 0) {
-         calculateDeltaXMinimizingVariance( dx, left_prev_point, right_prev_point, adjusted_block, total_intensity );
-         calculateDeltaYMinimizingVariance( dy, top_prev_point, bottom_prev_point, adjusted_block, total_intensity );
-         prev_point.x = dx;
-         prev_point.y = dy;
+      cv::Point light_position = prev_point;
+      if (light_position.x < 0 || light_position.y < 0) {
+         calculateDeltaXDividingIntensityInHalf( dx, block, total_intensity * 0.5 );
+         calculateDeltaYDividingIntensityInHalf( dy, block, total_intensity * 0.5 );
+         light_position = { block.x + dx, block.y + dy };
       }
 
-      const cv::Point light_position = prev_point;
-      const float intensity = AdjustedIntensities.at<float>(light_position.y, light_position.x);
-      LightInfos[intensity] = light_position;
-      drawLightPosition( longitude_latitude, light_position );
+      addLight( light_position, block );
    }
    else if (block.width > block.height) {
-      calculateDeltaXMinimizingVariance( dx, left_prev_point, right_prev_point, adjusted_block, total_intensity );
-      drawBlockLine( longitude_latitude, { dx, block.tl().y }, { dx, block.br().y } );
-      
-      const cv::Rect left_block(block.x, block.y, dx, block.height);
-      const cv::Rect right_block(block.x + dx, block.y, block.width - dx, block.height);
-      varianceCut( longitude_latitude, left_prev_point, left_block, iteration - 1 );
-      varianceCut( longitude_latitude, right_prev_point, right_block, iteration - 1 );
+      calculateDeltaXMinimizingVariance( dx, left_prev_point, right_prev_point, block, total_intensity );
+
+      const cv::Rect left_block(block.x, block.y, dx + 1, block.height);
+      const cv::Rect right_block(block.x + dx + 1, block.y, block.width - dx - 1, block.height);
+      varianceCut( left_prev_point, left_block, iteration - 1 );
+      varianceCut( right_prev_point, right_block, iteration - 1 );
    }
    else {
-      calculateDeltaYMinimizingVariance( dy, top_prev_point, bottom_prev_point, adjusted_block, total_intensity );
-      drawBlockLine( longitude_latitude, { block.tl().x, dy }, { block.br().x, dy } );
+      calculateDeltaYMinimizingVariance( dy, top_prev_point, bottom_prev_point, block, total_intensity );
 
-      const cv::Rect top_block(block.x, block.y, block.width, dy);
-      const cv::Rect bottom_block(block.x, block.y + dy, block.width, block.height - dy);
-      varianceCut( longitude_latitude, top_prev_point, top_block, iteration - 1 );
-      varianceCut( longitude_latitude, bottom_prev_point, bottom_block, iteration - 1 );
+      const cv::Rect top_block(block.x, block.y, block.width, dy + 1);
+      const cv::Rect bottom_block(block.x, block.y + dy + 1, block.width, block.height - dy - 1);
+      varianceCut( top_prev_point, top_block, iteration - 1 );
+      varianceCut( bottom_prev_point, bottom_block, iteration - 1 );
+   }
+}
+
+LightPosition::Region LightPosition::getRegion(const cv::Rect& block, bool use_variance) const
+// The priority is the energy of the block, or the intensity-weighted sum of the squared distances to its median point.
+{
+   Region region;
+   region.Block = block;
+
+   int dx, dy;
+   const double total_intensity = getIntensitySum( block );
+   calculateDeltaXDividingIntensityInHalf( dx, block, total_intensity * 0.5 );
+   calculateDeltaYDividingIntensityInHalf( dy, block, total_intensity * 0.5 );
+   region.Center = { block.x + dx, block.y + dy };
+
+   if (use_variance) {
+      const auto variance = static_cast<double>(calculateVariance( block, region.Center ));
+      region.Priority = variance * variance * static_cast<double>(block.area());
    }
+   else region.Priority = total_intensity;
+   return region;
+}
+
+void LightPosition::splitRegion(Region& first, Region& second, const Region& region, bool use_variance) const
+// Both of the split regions are never empty, so the region should have more than one pixel.
+{
+   const cv::Rect& block = region.Block;
+   const double total_intensity = getIntensitySum( block );
+   cv::Point first_point, second_point;
+   if (block.width > block.height) {
+      int dx;
+      if (use_variance) {
+         calculateDeltaXMinimizingVariance( dx, first_point, second_point, block, total_intensity );
+         dx++;
+      }
+      else {
+         calculateDeltaXDividingIntensityInHalf( dx, block, total_intensity * 0.5 );
+         dx = std::min( std::max( dx, 1 ), block.width - 1 );
+      }
+      first = getRegion( { block.x, block.y, dx, block.height }, use_variance );
+      second = getRegion( { block.x + dx, block.y, block.width - dx, block.height }, use_variance );
+   }
+   else {
+      int dy;
+      if (use_variance) {
+         calculateDeltaYMinimizingVariance( dy, first_point, second_point, block, total_intensity );
+         dy++;
+      }
+      else {
+         calculateDeltaYDividingIntensityInHalf( dy, block, total_intensity * 0.5 );
+         dy = std::min( std::max( dy, 1 ), block.height - 1 );
+      }
+      first = getRegion( { block.x, block.y, block.width, dy }, use_variance );
+      second = getRegion( { block.x, block.y + dy, block.width, block.height - dy }, use_variance );
+   }
+}
+
+void LightPosition::adaptiveCut(int light_num_to_find, bool use_variance)
+// It splits only the most significant region each time, so exactly light_num_to_find - 1 splits are done.
+// A single pixel cannot be split, so the lights can be fewer than requested only if the pixels are fewer.
+{
+   if (light_num_to_find <= 0) return;
+
+   std::vector<Region> single_pixels;
+   std::priority_queue<Region> regions;
+   regions.push( getRegion( { 0, 0, AdjustedIntensities.cols, AdjustedIntensities.rows }, use_variance ) );
+   while (!regions.empty() && static_cast<int>(regions.size() + single_pixels.size()) < light_num_to_find) {
+      const Region region = regions.top();
+      regions.pop();
+      if (region.Block.area() <= 1) {
+         single_pixels.emplace_back( region );
+         continue;
+      }
+
+      Region first, second;
+      splitRegion( first, second, region, use_variance );
+      regions.push( first );
+      regions.push( second );
+   }
+
+   for (const auto& region : single_pixels) addLight( region.Center, region.Block );
+   for (; !regions.empty(); regions.pop()) addLight( regions.top().Center, regions.top().Block );
 }
 
 void LightPosition::estimateLightPositions(
-   std::vector<cv::Point>& light_points,
+   std::vector<LightInfo>& lights,
    const cv::Mat& longitude_latitude, 
    int light_num_to_find, 
-   bool use_median_cut
+   ALGORITHM algorithm
 )
+// It only reads the image. The lights are sorted from the brightest block, and if the power of 2 blocks of the
+// non-adaptive algorithms are more than light_num_to_find, the dimmest ones are dropped.
 {
    std::cout << ">> Find Light Positions...\n";
-   LightInfos.clear();
+   Lights.clear();
    LightNum = getNextHighestPowerOf2( light_num_to_find );
    const int iteration = LightNum == 0 ? 0 : static_cast<int>(log2( LightNum ));
 
    adjustIntensities( longitude_latitude );
 
-   cv::Mat result = longitude_latitude.clone();
-   if (use_median_cut) medianCut( result, { 0, 0, result.cols, result.rows }, iteration );
-
-   light_points.clear();
-   for (auto it = LightInfos.begin(); it != std::next( LightInfos.begin(), light_num_to_find ); ++it) {
-      light_points.emplace_back( it->second );
+   const cv::Rect whole(0, 0, longitude_latitude.cols, longitude_latitude.rows);
+   switch (algorithm) {
+      case ALGORITHM::MEDIAN_CUT:
+         medianCut( whole, iteration );
+         break;
+      case ALGORITHM::VARIANCE_CUT:
+         buildMomentIntegrals();
+         varianceCut( { -1, -1 }, whole, iteration );
+         MomentIntegrals.release();
+         break;
+      case ALGORITHM::ADAPTIVE_MEDIAN_CUT:
+         adaptiveCut( light_num_to_find, false );
+         break;
+      case ALGORITHM::ADAPTIVE_VARIANCE_CUT:
+         buildMomentIntegrals();
+         adaptiveCut( light_num_to_find, true );
+         MomentIntegrals.release();
+         break;
    }
-   cv::imshow( "Light Positions", result );
+
+   std::stable_sort(
+      Lights.begin(), Lights.end(),
+      [](const LightInfo& a, const LightInfo& b) { return a.Intensity > b.Intensity; }
+   );
+   if (static_cast<int>(Lights.size()) > light_num_to_find) Lights.resize( std::max( light_num_to_find, 0 ) );
+   lights = Lights;
    std::cout << ">> Finding Done.\n\n";
 }
\ No newline at end of file
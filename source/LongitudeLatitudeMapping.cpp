@@ -1,28 +1,5 @@
 #include "LongitudeLatitudeMapping.h"
 
-void LongitudeLatitudeMapping::getBilinearInterpolatedColor(
-   cv::Vec3b& bgr_color, 
-   const cv::Mat& image, 
-   const cv::Vec2d& point
-)
-{
-   const int x0 = static_cast<int>(floor( point(0) ));
-   const int y0 = static_cast<int>(floor( point(1) ));
-   const int x1 = std::min( x0 + 1, image.cols - 1 );
-   const int y1 = std::min( y0 + 1, image.rows - 1 );
-   const auto tx = point(0) - static_cast<double>(x0);
-   const auto ty = point(1) - static_cast<double>(y0);
-
-   const auto* curr_row = image.ptr<cv::Vec3b>(y0);
-   const auto* next_row = image.ptr<cv::Vec3b>(y1);
-   bgr_color = static_cast<cv::Vec3b>(
-      static_cast<cv::Vec3d>(curr_row[x0]) * (1.0 - tx) * (1.0 - ty) + 
-      static_cast<cv::Vec3d>(curr_row[x1]) * tx * (1.0 - ty) + 
-      static_cast<cv::Vec3d>(next_row[x0]) * (1.0 - tx) * ty + 
-      static_cast<cv::Vec3d>(next_row[x1]) * tx * ty
-   );
-}
-
 void LongitudeLatitudeMapping::getTextureCoordinates(
    cv::Point2d& texture_point, 
    const cv::Point& image_point, 
@@ -39,7 +16,7 @@ void LongitudeLatitudeMapping::getSphereCoordinatesForFisheye(
 )
 // The sphere coordinates is right-handed system, whose y-axis is up-vector and -z-axis view-vector.
 // When the point is on +y-axis, theta is 0 radian. When the point is on -x-axis, phi is 0 radian.
-// The range of phi is [0, PI].
+// The range of phi is [0, PI], so z is never positive and the incident angle from the optical axis is at most PI/2.
 {
    const double phi = longitude_latitude.x * CV_PI;
    const double theta = longitude_latitude.y * CV_PI;
@@ -52,53 +29,54 @@ void LongitudeLatitudeMapping::getSphereCoordinatesForFisheye(
    on_sphere.z = -sin_theta * sin_phi;
 }
 
-void LongitudeLatitudeMapping::getFisheyeCoordinatesFromSphere(
-   cv::Point2d& fisheye_point, 
-   const cv::Point3d& on_sphere
+const BilinearSampler::RemapTable& LongitudeLatitudeMapping::getRemapTable(
+   const RemapKey& key,
+   int thread_num,
+   const RowsCalculator& calculate_rows
 )
-// fisheye_point's range is [-1, 1]. It means that fisheye image which is circle has range of [-1, 1].
-// Image point from 90 degree of incidence projected on the perimeter of circle whose radius is 1.
 {
-   const double fisheye_angle = atan2( 
-      sqrt( on_sphere.x * on_sphere.x + on_sphere.y * on_sphere.y ), 
-      abs( on_sphere.z )
+   const auto it = RemapTables.find( key );
+   if (it != RemapTables.end()) return it->second;
+
+   BilinearSampler::RemapTable& table = RemapTables[key];
+   table.SourceSize = key.SourceSize;
+   table.ConvertedSize = key.ConvertedSize;
+   table.Entries.resize( static_cast<size_t>(key.ConvertedSize.area()) );
+   runRowsInParallel(
+      key.ConvertedSize.height, thread_num,
+      [&](int start, int end) { calculate_rows( table, { start, end } ); }
    );
-   const double radius = fisheye_angle * 2.0 / CV_PI;
-   const double rotation_angle_on_image_plane = atan2( on_sphere.y, on_sphere.x );
-   fisheye_point.x = radius * cos( rotation_angle_on_image_plane );
-   fisheye_point.y = radius * sin( rotation_angle_on_image_plane );
+   return table;
 }
 
-void LongitudeLatitudeMapping::convertFisheye(cv::Mat& converted, const cv::Mat& fisheye)
+void LongitudeLatitudeMapping::buildFisheyeTable(
+   const cv::Size& fisheye_size,
+   const cv::Size& converted_size,
+   int thread_num
+)
 {
-   std::cout << ">> Convert Fisheye Image to Longitude-Latitude Image...\n";
-   converted = cv::Mat::zeros( fisheye.size(), fisheye.type() );
-   for (int j = 0; j < converted.rows; ++j) {
-      auto* converted_ptr = converted.ptr<cv::Vec3b>(j);
-      for (int i = 0; i < converted.cols; ++i) {
-         cv::Point2d texture_point;
-         getTextureCoordinates( texture_point, { i, j }, converted.size() );
-
-         cv::Point3d on_sphere;
-         getSphereCoordinatesForFisheye( on_sphere, texture_point );
-
-         cv::Point2d fisheye_point;
-         getFisheyeCoordinatesFromSphere( fisheye_point, on_sphere );
-         if (fisheye_point.x * fisheye_point.x + fisheye_point.y * fisheye_point.y > 1.0) continue;
-
-         cv::Point2d fisheye_image_point;
-         fisheye_image_point.x = (fisheye_point.x + 1.0) * 0.5 * fisheye.cols;
-         fisheye_image_point.y = (fisheye_point.y + 1.0) * 0.5 * fisheye.rows;
+   buildFisheyeTable( fisheye_size, converted_size, EquidistantLens(), thread_num );
+}
 
-         if (fisheye_image_point.x < 0 || fisheye_image_point.x >= fisheye.cols ||
-             fisheye_image_point.y < 0 || fisheye_image_point.y >= fisheye.rows) continue;
+void LongitudeLatitudeMapping::remap(
+   cv::Mat& converted,
+   const cv::Mat& source,
+   const BilinearSampler::RemapTable& table,
+   int thread_num
+)
+{
+   const cv::Mat continuous_source = source.isContinuous() ? source : source.clone();
+   if (converted.data == continuous_source.data) converted.release();
+   converted.create( table.ConvertedSize, CV_8UC3 );
+   runRowsInParallel(
+      converted.rows, thread_num,
+      [&](int start, int end) { BilinearSampler::remap( converted, continuous_source, table, { start, end } ); }
+   );
+}
 
-         cv::Vec3b bgr_color;
-         getBilinearInterpolatedColor( bgr_color, fisheye, fisheye_image_point );
-         converted_ptr[i] = bgr_color;
-      }
-   }
-   std::cout << ">> Converting Done.\n\n";
+void LongitudeLatitudeMapping::convertFisheye(cv::Mat& converted, const cv::Mat& fisheye, int thread_num)
+{
+   convertFisheye( converted, fisheye, EquidistantLens(), thread_num );
 }
 
 void LongitudeLatitudeMapping::getSphereCoordinatesForMirrorball(
@@ -130,15 +108,20 @@ void LongitudeLatitudeMapping::getMirrorballCoordinatesFromSphere(
    mirrorball_point.y = on_sphere.y * coef;
 }
 
-
-void LongitudeLatitudeMapping::convertMirrorball(cv::Mat& converted, const cv::Mat& mirrorball)
+void LongitudeLatitudeMapping::calculateMirrorballTable(
+   BilinearSampler::RemapTable& table,
+   const cv::Size& mirrorball_size,
+   const cv::Range& row_range
+)
 {
-   converted = cv::Mat::zeros( mirrorball.rows, mirrorball.cols * 2, mirrorball.type() );
-   for (int j = 0; j < converted.rows; ++j) {
-      auto* converted_ptr = converted.ptr<cv::Vec3b>(j);
-      for (int i = 0; i < converted.cols; ++i) {
+   const cv::Size& converted_size = table.ConvertedSize;
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      auto* entries = table.Entries.data() + static_cast<size_t>(j) * converted_size.width;
+      for (int i = 0; i < converted_size.width; ++i) {
+         BilinearSampler::getInvalidRemapEntry( entries[i] );
+
          cv::Point2d texture_point;
-         getTextureCoordinates( texture_point, { i, j }, converted.size() );
+         getTextureCoordinates( texture_point, { i, j }, converted_size );
 
          cv::Point3d on_sphere;
          getSphereCoordinatesForMirrorball( on_sphere, texture_point );
@@ -148,15 +131,133 @@ void LongitudeLatitudeMapping::convertMirrorball(cv::Mat& converted, const cv::M
          if (mirrorball_point.x * mirrorball_point.x + mirrorball_point.y * mirrorball_point.y > 1.0) continue;
 
          cv::Point2d mirrorball_image_point;
-         mirrorball_image_point.x = (mirrorball_point.x + 1.0) * 0.5 * mirrorball.cols;
-         mirrorball_image_point.y = (mirrorball_point.y + 1.0) * 0.5 * mirrorball.rows;
+         mirrorball_image_point.x = (mirrorball_point.x + 1.0) * 0.5 * mirrorball_size.width;
+         mirrorball_image_point.y = (mirrorball_point.y + 1.0) * 0.5 * mirrorball_size.height;
 
-         if (mirrorball_image_point.x < 0 || mirrorball_image_point.x >= mirrorball.cols ||
-             mirrorball_image_point.y < 0 || mirrorball_image_point.y >= mirrorball.rows) continue;
+         if (mirrorball_image_point.x < 0 || mirrorball_image_point.x >= mirrorball_size.width ||
+             mirrorball_image_point.y < 0 || mirrorball_image_point.y >= mirrorball_size.height) continue;
 
-         cv::Vec3b bgr_color;
-         getBilinearInterpolatedColor( bgr_color, mirrorball, mirrorball_image_point );
-         converted_ptr[i] = bgr_color;
+         BilinearSampler::getRemapEntry( entries[i], mirrorball_image_point, mirrorball_size );
       }
    }
+}
+
+const BilinearSampler::RemapTable& LongitudeLatitudeMapping::getMirrorballTable(
+   const cv::Size& mirrorball_size,
+   const cv::Size& converted_size,
+   int thread_num
+)
+{
+   return getRemapTable(
+      { PROJECTION::MIRRORBALL, mirrorball_size, converted_size, {} },
+      thread_num,
+      [&](BilinearSampler::RemapTable& table, const cv::Range& row_range) {
+         calculateMirrorballTable( table, mirrorball_size, row_range );
+      }
+   );
+}
+
+void LongitudeLatitudeMapping::buildMirrorballTable(
+   const cv::Size& mirrorball_size,
+   const cv::Size& converted_size,
+   int thread_num
+)
+{
+   getMirrorballTable( mirrorball_size, converted_size, thread_num );
+}
+
+void LongitudeLatitudeMapping::convertMirrorball(cv::Mat& converted, const cv::Mat& mirrorball, int thread_num)
+{
+   const cv::Size converted_size(mirrorball.cols * 2, mirrorball.rows);
+   remap( converted, mirrorball, getMirrorballTable( mirrorball.size(), converted_size, thread_num ), thread_num );
+}
+
+void LongitudeLatitudeMapping::getCubemapDirection(cv::Point3d& direction, int face, const cv::Point2d& face_point)
+// face_point's range is [-1, 1], and its y-axis goes along the rows of the face.
+// Each face is oriented as the major axis table of the cube map in the OpenGL specification.
+// The direction is not normalized.
+{
+   const double s = face_point.x;
+   const double t = face_point.y;
+   switch (face) {
+      case 0: direction = cv::Point3d(1.0, -t, -s); break;
+      case 1: direction = cv::Point3d(-1.0, -t, s); break;
+      case 2: direction = cv::Point3d(s, 1.0, t); break;
+      case 3: direction = cv::Point3d(s, -1.0, -t); break;
+      case 4: direction = cv::Point3d(s, -t, 1.0); break;
+      default: direction = cv::Point3d(-s, -t, -1.0); break;
+   }
+}
+
+void LongitudeLatitudeMapping::getReflectedTextureCoordinates(cv::Point2d& texture_point, const cv::Point3d& on_sphere)
+// It is the same as the texture coordinates of calculateReflectedTextureInWC() in BasicPipeline.frag.
+// The x coordinate wraps around into [0, 1) as the texture repeats.
+{
+   texture_point.x = atan2( -on_sphere.y, on_sphere.x ) / CV_PI;
+   if (texture_point.x < 0.0) texture_point.x += 1.0;
+   texture_point.y = acos( std::clamp( -on_sphere.z, -1.0, 1.0 ) ) / CV_PI;
+}
+
+void LongitudeLatitudeMapping::calculateCubemapTable(
+   BilinearSampler::RemapTable& table,
+   const cv::Size& longitude_latitude_size,
+   const cv::Range& row_range
+)
+{
+   const int face_size = table.ConvertedSize.width;
+   const double max_x = longitude_latitude_size.width - 1.0;
+   const double max_y = longitude_latitude_size.height - 1.0;
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      const int face = j / face_size;
+      const double t = 2.0 * ((j % face_size) + 0.5) / face_size - 1.0;
+      auto* entries = table.Entries.data() + static_cast<size_t>(j) * face_size;
+      for (int i = 0; i < face_size; ++i) {
+         BilinearSampler::getInvalidRemapEntry( entries[i] );
+
+         cv::Point3d direction;
+         getCubemapDirection( direction, face, { 2.0 * (i + 0.5) / face_size - 1.0, t } );
+         if (direction.y < 0.0) continue;
+
+         const cv::Point3d on_sphere = direction / cv::norm( direction );
+         cv::Point2d texture_point;
+         getReflectedTextureCoordinates( texture_point, on_sphere );
+
+         const cv::Point2d image_point(
+            std::clamp( texture_point.x * longitude_latitude_size.width - 0.5, 0.0, max_x ),
+            std::clamp( texture_point.y * longitude_latitude_size.height - 0.5, 0.0, max_y )
+         );
+         BilinearSampler::getRemapEntry( entries[i], image_point, longitude_latitude_size );
+      }
+   }
+}
+
+const BilinearSampler::RemapTable& LongitudeLatitudeMapping::getCubemapTable(
+   const cv::Size& longitude_latitude_size,
+   int face_size,
+   int thread_num
+)
+{
+   return getRemapTable(
+      { PROJECTION::CUBEMAP, longitude_latitude_size, cv::Size(face_size, face_size * 6), {} },
+      thread_num,
+      [&](BilinearSampler::RemapTable& table, const cv::Range& row_range) {
+         calculateCubemapTable( table, longitude_latitude_size, row_range );
+      }
+   );
+}
+
+void LongitudeLatitudeMapping::buildCubemapTable(const cv::Size& longitude_latitude_size, int face_size, int thread_num)
+{
+   getCubemapTable( longitude_latitude_size, face_size, thread_num );
+}
+
+void LongitudeLatitudeMapping::convertToCubemap(
+   cv::Mat& cubemap,
+   const cv::Mat& longitude_latitude,
+   int face_size,
+   int thread_num
+)
+{
+   const BilinearSampler::RemapTable& table = getCubemapTable( longitude_latitude.size(), face_size, thread_num );
+   remap( cubemap, longitude_latitude, table, thread_num );
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "MeshCache.h"
+
+#include <filesystem>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MeshCache::MeshCache() :
+   MappedData( nullptr ), MappedSize( 0 ), ParsedHeader{}
+#ifdef _WIN32
+   , File( INVALID_HANDLE_VALUE ), Mapping( nullptr )
+#endif
+{
+}
+
+MeshCache::~MeshCache()
+{
+   unload();
+}
+
+const float* MeshCache::getVertexData() const
+{
+   return MappedData == nullptr ? ParsedVertices.data() : reinterpret_cast<const float*>(MappedData + sizeof( Header ));
+}
+
+int MeshCache::getVertexNum() const
+{
+   return static_cast<int>(getHeader()->VertexNum);
+}
+
+int MeshCache::getFloatsPerVertex() const
+{
+   return static_cast<int>(getHeader()->FloatsPerVertex);
+}
+
+std::string MeshCache::getCachePath(const std::string& text_path)
+// The name has the hash of the absolute source path, so the models of the same name in different directories do not
+// overwrite each other's caches.
+{
+   const std::string cache_directory_path = std::string(CMAKE_BINARY_DIR) + "/mesh_cache";
+   std::error_code error;
+   std::filesystem::create_directories( cache_directory_path, error );
+
+   std::filesystem::path absolute_path = std::filesystem::absolute( text_path, error );
+   if (error) absolute_path = text_path;
+   const std::string source_path = absolute_path.lexically_normal().generic_string();
+   std::ostringstream file_name;
+   file_name << std::filesystem::path(text_path).stem().string() << "-" << std::hex << std::setw( 16 )
+      << std::setfill( '0' ) << getFNV1aHash( source_path.data(), source_path.size() ) << ".mesh";
+   return cache_directory_path + "/" + file_name.str();
+}
+
+uint64_t MeshCache::getHash(const std::string& file_path)
+{
+   std::ifstream file(file_path, std::ios::binary);
+   if (!file.is_open()) return 0;
+
+   uint64_t hash = FNV1aOffsetBasis;
+   std::vector<char> buffer(1 << 16);
+   while (file) {
+      file.read( buffer.data(), static_cast<std::streamsize>(buffer.size()) );
+      hash = getFNV1aHash( buffer.data(), static_cast<size_t>(file.gcount()), hash );
+   }
+   return hash;
+}
+
+bool MeshCache::parseTextModel(
+   std::vector<float>& vertices,
+   const std::string& text_path,
+   int text_floats_per_vertex,
+   int floats_per_vertex
+)
+{
+   std::ifstream file(text_path);
+   if (!file.is_open()) {
+      std::cerr << "Could not open model file " << text_path << "\n";
+      return false;
+   }
+
+   int polygon_num;
+   file >> polygon_num;
+   vertices.clear();
+   vertices.reserve( static_cast<size_t>(polygon_num) * 3 * floats_per_vertex );
+   for (int i = 0; i < polygon_num; ++i) {
+      int polygon_vertex_num;
+      file >> polygon_vertex_num;
+      for (int v = 0; v < polygon_vertex_num; ++v) {
+         for (int f = 0; f < text_floats_per_vertex; ++f) {
+            float attribute;
+            file >> attribute;
+            if (f < floats_per_vertex) vertices.emplace_back( attribute );
+         }
+      }
+   }
+   if (file.fail()) {
+      std::cerr << "Could not parse model file " << text_path << "\n";
+      return false;
+   }
+   return true;
+}
+
+bool MeshCache::writeCache(const std::string& cache_path, const Header& header, const std::vector<float>& vertices)
+{
+   return writeFileAtomically(
+      cache_path,
+      [&](std::ofstream& file) {
+         file.write( reinterpret_cast<const char*>(&header), sizeof( Header ) );
+         file.write( reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof( float )) );
+      }
+   );
+}
+
+bool MeshCache::map(const std::string& cache_path)
+{
+   unload();
+#ifdef _WIN32
+   File = CreateFileA( cache_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+   if (File == INVALID_HANDLE_VALUE) return false;
+
+   LARGE_INTEGER file_size;
+   if (!GetFileSizeEx( File, &file_size ) || file_size.QuadPart < static_cast<LONGLONG>(sizeof( Header ))) {
+      unload();
+      return false;
+   }
+   Mapping = CreateFileMappingA( File, nullptr, PAGE_READONLY, 0, 0, nullptr );
+   if (Mapping == nullptr) {
+      unload();
+      return false;
+   }
+   MappedData = static_cast<uchar*>(MapViewOfFile( Mapping, FILE_MAP_READ, 0, 0, 0 ));
+   if (MappedData == nullptr) {
+      unload();
+      return false;
+   }
+   MappedSize = static_cast<size_t>(file_size.QuadPart);
+#else
+   const int file_descriptor = open( cache_path.c_str(), O_RDONLY );
+   if (file_descriptor < 0) return false;
+
+   struct stat file_status{};
+   if (fstat( file_descriptor, &file_status ) != 0 || file_status.st_size < static_cast<off_t>(sizeof( Header ))) {
+      close( file_descriptor );
+      return false;
+   }
+   void* data = mmap( nullptr, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0 );
+   close( file_descriptor );
+   if (data == MAP_FAILED) return false;
+
+   MappedData = static_cast<uchar*>(data);
+   MappedSize = static_cast<size_t>(file_status.st_size);
+#endif
+   return true;
+}
+
+void MeshCache::unload()
+{
+#ifdef _WIN32
+   if (MappedData != nullptr) UnmapViewOfFile( MappedData );
+   if (Mapping != nullptr) CloseHandle( Mapping );
+   if (File != INVALID_HANDLE_VALUE) CloseHandle( File );
+   Mapping = nullptr;
+   File = INVALID_HANDLE_VALUE;
+#else
+   if (MappedData != nullptr) munmap( MappedData, MappedSize );
+#endif
+   MappedData = nullptr;
+   MappedSize = 0;
+   ParsedHeader = Header{};
+   ParsedVertices.clear();
+}
+
+bool MeshCache::isValid(int floats_per_vertex) const
+{
+   if (MappedData == nullptr || MappedSize < sizeof( Header )) return false;
+
+   const Header* header = getHeader();
+   return std::memcmp( header->Magic, CacheMagic, sizeof( CacheMagic ) ) == 0 &&
+      header->Version == CacheVersion &&
+      header->FloatsPerVertex == static_cast<uint32_t>(floats_per_vertex) &&
+      MappedSize == sizeof( Header ) + static_cast<size_t>(header->VertexNum) * header->FloatsPerVertex * sizeof( float );
+}
+
+bool MeshCache::load(const std::string& text_path, int text_floats_per_vertex, int floats_per_vertex)
+{
+   std::error_code error;
+   const auto source_size = static_cast<uint64_t>(std::filesystem::file_size( text_path, error ));
+   if (error) {
+      std::cerr << "Could not open model file " << text_path << "\n";
+      return false;
+   }
+   const auto source_modified_time =
+      static_cast<int64_t>(std::filesystem::last_write_time( text_path, error ).time_since_epoch().count());
+
+   const std::string cache_path = getCachePath( text_path );
+   uint64_t source_hash = 0;
+   if (map( cache_path ) && isValid( floats_per_vertex ) && getHeader()->SourceSize == source_size) {
+      if (getHeader()->SourceModifiedTime == source_modified_time) return true;
+
+      // The file can be touched without any change, e.g. by a checkout, so the hash decides it.
+      source_hash = getHash( text_path );
+      if (getHeader()->SourceHash == source_hash) {
+         Header header = *getHeader();
+         header.SourceModifiedTime = source_modified_time;
+         unload();
+         std::fstream file(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+         file.write( reinterpret_cast<const char*>(&header), sizeof( Header ) );
+         file.close();
+         return map( cache_path );
+      }
+   }
+   unload();
+
+   std::vector<float> vertices;
+   if (!parseTextModel( vertices, text_path, text_floats_per_vertex, floats_per_vertex )) return false;
+
+   Header header{};
+   std::memcpy( header.Magic, CacheMagic, sizeof( CacheMagic ) );
+   header.Version = CacheVersion;
+   header.FloatsPerVertex = static_cast<uint32_t>(floats_per_vertex);
+   header.VertexNum = static_cast<uint32_t>(vertices.size() / floats_per_vertex);
+   header.SourceSize = source_size;
+   header.SourceModifiedTime = source_modified_time;
+   header.SourceHash = source_hash != 0 ? source_hash : getHash( text_path );
+   if (!writeCache( cache_path, header, vertices ) || !map( cache_path ) || !isValid( floats_per_vertex )) {
+      std::cerr << "Could not write mesh cache " << cache_path << ", so the parsed model is used.\n";
+      unload();
+      ParsedHeader = header;
+      ParsedVertices = std::move( vertices );
+   }
+   return true;
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "MeshOptimizer.h"
+
+void MeshOptimizer::deduplicateVertices(
+   std::vector<GLfloat>& unique_vertices,
+   std::vector<GLuint>& indices,
+   const GLfloat* vertices,
+   int vertex_num,
+   int floats_per_vertex
+)
+{
+   const size_t vertex_size = floats_per_vertex * sizeof( GLfloat );
+   std::unordered_map<uint64_t, std::vector<GLuint>> buckets;
+   buckets.reserve( static_cast<size_t>(vertex_num) );
+   unique_vertices.clear();
+   indices.resize( static_cast<size_t>(vertex_num) );
+   for (int i = 0; i < vertex_num; ++i) {
+      const GLfloat* vertex = vertices + static_cast<size_t>(i) * floats_per_vertex;
+      auto& bucket = buckets[getFNV1aHash( vertex, vertex_size )];
+      const auto it = std::find_if(
+         bucket.begin(), bucket.end(),
+         [&](GLuint index) {
+            return std::memcmp( unique_vertices.data() + static_cast<size_t>(index) * floats_per_vertex, vertex, vertex_size ) == 0;
+         }
+      );
+      if (it != bucket.end()) indices[i] = *it;
+      else {
+         const auto index = static_cast<GLuint>(unique_vertices.size() / floats_per_vertex);
+         unique_vertices.insert( unique_vertices.end(), vertex, vertex + floats_per_vertex );
+         bucket.emplace_back( index );
+         indices[i] = index;
+      }
+   }
+}
+
+int MeshOptimizer::getNextFanningVertex(
+   std::vector<int>& dead_ends,
+   int& cursor,
+   const std::vector<int>& candidates,
+   const std::vector<int>& live_triangle_nums,
+   const std::vector<int>& cache_times,
+   int time,
+   int cache_size
+)
+// The candidate which will still be in the cache after its remaining triangles are emitted is preferred, and the
+// oldest one in the cache among them. If there is none, it goes back to the recent vertices with triangles left, and
+// then to the next vertex in the input order.
+{
+   int next = -1, max_priority = -1;
+   for (const auto& candidate : candidates) {
+      if (live_triangle_nums[candidate] <= 0) continue;
+
+      int priority = 0;
+      if (time - cache_times[candidate] + 2 * live_triangle_nums[candidate] <= cache_size) {
+         priority = time - cache_times[candidate];
+      }
+      if (priority > max_priority) {
+         max_priority = priority;
+         next = candidate;
+      }
+   }
+   if (next >= 0) return next;
+
+   while (!dead_ends.empty()) {
+      const int dead_end = dead_ends.back();
+      dead_ends.pop_back();
+      if (live_triangle_nums[dead_end] > 0) return dead_end;
+   }
+   for (; cursor < static_cast<int>(live_triangle_nums.size()); ++cursor) {
+      if (live_triangle_nums[cursor] > 0) return cursor;
+   }
+   return -1;
+}
+
+void MeshOptimizer::reorderForVertexCache(std::vector<GLuint>& indices, int vertex_num, int cache_size)
+{
+   const int triangle_num = static_cast<int>(indices.size() / 3);
+   if (triangle_num == 0 || vertex_num == 0) return;
+
+   // The triangles around each vertex are listed in the offsets of the vertex, like a compressed sparse row.
+   std::vector<int> live_triangle_nums(vertex_num, 0);
+   for (const auto& index : indices) live_triangle_nums[index]++;
+   std::vector<int> offsets(vertex_num + 1, 0);
+   for (int v = 0; v < vertex_num; ++v) offsets[v + 1] = offsets[v] + live_triangle_nums[v];
+   std::vector<int> adjacent_triangles(offsets.back());
+   std::vector<int> filled(offsets.begin(), offsets.end() - 1);
+   for (int t = 0; t < triangle_num * 3; ++t) adjacent_triangles[filled[indices[t]]++] = t / 3;
+
+   std::vector<GLuint> reordered;
+   reordered.reserve( indices.size() );
+   std::vector<int> cache_times(vertex_num, 0);
+   std::vector<bool> emitted(triangle_num, false);
+   std::vector<int> dead_ends, candidates;
+   int time = cache_size + 1, cursor = 1;
+   for (int fanning = 0; fanning >= 0;) {
+      candidates.clear();
+      for (int a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+         const int triangle = adjacent_triangles[a];
+         if (emitted[triangle]) continue;
+
+         for (int k = 0; k < 3; ++k) {
+            const GLuint vertex = indices[triangle * 3 + k];
+            reordered.emplace_back( vertex );
+            dead_ends.emplace_back( vertex );
+            candidates.emplace_back( vertex );
+            live_triangle_nums[vertex]--;
+            if (time - cache_times[vertex] > cache_size) cache_times[vertex] = time++;
+         }
+         emitted[triangle] = true;
+      }
+      fanning = getNextFanningVertex( dead_ends, cursor, candidates, live_triangle_nums, cache_times, time, cache_size );
+   }
+   indices = std::move( reordered );
+}
+
+float MeshOptimizer::getACMR(const std::vector<GLuint>& indices, int vertex_num, int cache_size)
+{
+   const size_t triangle_num = indices.size() / 3;
+   if (triangle_num == 0) return 0.0f;
+
+   // A vertex is in the FIFO cache if it entered within the last cache_size misses.
+   int miss_num = 0;
+   std::vector<int> entered_times(vertex_num, -cache_size - 1);
+   for (const auto& index : indices) {
+      if (miss_num - entered_times[index] > cache_size) entered_times[index] = miss_num++;
+   }
+   return static_cast<float>(miss_num) / static_cast<float>(triangle_num);
+}
\ No newline at end of file
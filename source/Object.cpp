@@ -1,11 +1,12 @@
 #include "Object.h"
 
 ObjectGL::ObjectGL() :
-   ImageBuffer( nullptr ), VAO( 0 ), VBO( 0 ), DrawMode( 0 ), VerticesCount( 0 ),
+   ImageBuffer( nullptr ), VAO( 0 ), VBO( 0 ), EBO( 0 ), DrawMode( 0 ), Format( VERTEX_FORMAT::FLOAT32 ),
+   PositionScale( 1.0f ), PositionOffset( 0.0f ), VerticesCount( 0 ), IndicesCount( 0 ), KeyframeNum( 0 ),
    EmissionColor( 0.0f, 0.0f, 0.0f, 1.0f ),
    AmbientReflectionColor( 0.2f, 0.2f, 0.2f, 1.0f ),
    DiffuseReflectionColor( 0.8f, 0.8f, 0.8f, 1.0f ),
-   SpecularReflectionColor( 0.0f, 0.0f, 0.0f, 1.0f ), SpecularReflectionExponent( 0.0f )
+   SpecularReflectionColor( 0.0f, 0.0f, 0.0f, 1.0f ), SpecularReflectionExponent( 0.0f ), Roughness( 0.0f )
 {
 }
 
@@ -15,8 +16,13 @@ ObjectGL::~ObjectGL()
       glDeleteVertexArrays( 1, &VAO );
       glDeleteBuffers( 1, &VBO );
    }
+   if (EBO != 0) glDeleteBuffers( 1, &EBO );
    for (const auto& texture_id : TextureID) {
-      if (texture_id != 0) glDeleteTextures( 1, &texture_id );
+      const bool is_shared = std::any_of(
+         SharedTextures.begin(), SharedTextures.end(),
+         [texture_id](const TextureCacheGL::Handle& shared) { return *shared == texture_id; }
+      );
+      if (texture_id != 0 && !is_shared) glDeleteTextures( 1, &texture_id );
    }
    for (const auto& buffer : CustomBuffers) {
       if (buffer.second != 0) glDeleteBuffers( 1, &buffer.second );
@@ -49,6 +55,11 @@ void ObjectGL::setSpecularReflectionExponent(const float& specular_reflection_ex
    SpecularReflectionExponent = specular_reflection_exponent;
 }
 
+void ObjectGL::setRoughness(float roughness)
+{
+   Roughness = std::clamp( roughness, 0.0f, 1.0f );
+}
+
 bool ObjectGL::prepareTexture2DUsingFreeImage(const std::string& file_path, bool is_grayscale) const
 {
    const FREE_IMAGE_FORMAT format = FreeImage_GetFileType( file_path.c_str(), 0 );
@@ -115,6 +126,15 @@ int ObjectGL::addTexture(const cv::Mat& texture)
    return static_cast<int>(TextureID.size() - 1);
 }
 
+int ObjectGL::addTexture(const TextureCacheGL::Handle& texture)
+{
+   if (texture == nullptr) return -1;
+
+   SharedTextures.emplace_back( texture );
+   TextureID.emplace_back( *texture );
+   return static_cast<int>(TextureID.size() - 1);
+}
+
 void ObjectGL::addTexture(int width, int height, bool is_grayscale)
 {
    GLuint texture_id = 0;
@@ -153,31 +173,146 @@ int ObjectGL::addTexture(const uint8_t* image_buffer, int width, int height, boo
 
 void ObjectGL::prepareTexture(bool normals_exist) const
 {
-   const uint offset = normals_exist ? 6 : 3;
-   glVertexArrayAttribFormat( VAO, TextureLoc, 2, GL_FLOAT, GL_FALSE, offset * sizeof( GLfloat ) );
+   if (Format == VERTEX_FORMAT::QUANTIZED) {
+      const uint offset = normals_exist ? 6 : 4;
+      glVertexArrayAttribFormat( VAO, TextureLoc, 2, GL_HALF_FLOAT, GL_FALSE, offset * sizeof( GLushort ) );
+   }
+   else {
+      const uint offset = normals_exist ? 6 : 3;
+      glVertexArrayAttribFormat( VAO, TextureLoc, 2, GL_FLOAT, GL_FALSE, offset * sizeof( GLfloat ) );
+   }
    glEnableVertexArrayAttrib( VAO, TextureLoc );
    glVertexArrayAttribBinding( VAO, TextureLoc, 0 );
 }
 
 void ObjectGL::prepareNormal() const
 {
-   glVertexArrayAttribFormat( VAO, NormalLoc, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( GLfloat ) );
+   if (Format == VERTEX_FORMAT::QUANTIZED) {
+      glVertexArrayAttribFormat( VAO, NormalLoc, 2, GL_SHORT, GL_TRUE, 4 * sizeof( GLushort ) );
+   }
+   else glVertexArrayAttribFormat( VAO, NormalLoc, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( GLfloat ) );
    glEnableVertexArrayAttrib( VAO, NormalLoc );
    glVertexArrayAttribBinding( VAO, NormalLoc, 0 );
 }
 
 void ObjectGL::prepareVertexBuffer(int n_bytes_per_vertex)
+{
+   prepareVertexBuffer( n_bytes_per_vertex, DataBuffer.data(), DataBuffer.size() );
+}
+
+void ObjectGL::prepareVertexBuffer(int n_bytes_per_vertex, const GLfloat* data, size_t n_floats)
+{
+   prepareVertexBuffer( n_bytes_per_vertex, static_cast<const GLvoid*>(data), sizeof( GLfloat ) * n_floats );
+}
+
+void ObjectGL::prepareVertexBuffer(int n_bytes_per_vertex, const GLvoid* data, size_t n_bytes)
 {
    glCreateBuffers( 1, &VBO );
-   glNamedBufferStorage( VBO, sizeof( GLfloat ) * DataBuffer.size(), DataBuffer.data(), GL_DYNAMIC_STORAGE_BIT );
+   glNamedBufferStorage( VBO, static_cast<GLsizeiptr>(n_bytes), data, GL_DYNAMIC_STORAGE_BIT );
 
    glCreateVertexArrays( 1, &VAO );
    glVertexArrayVertexBuffer( VAO, 0, VBO, 0, n_bytes_per_vertex );
-   glVertexArrayAttribFormat( VAO, VertexLoc, 3, GL_FLOAT, GL_FALSE, 0 );
+   if (Format == VERTEX_FORMAT::QUANTIZED) glVertexArrayAttribFormat( VAO, VertexLoc, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 );
+   else glVertexArrayAttribFormat( VAO, VertexLoc, 3, GL_FLOAT, GL_FALSE, 0 );
    glEnableVertexArrayAttrib( VAO, VertexLoc );
    glVertexArrayAttribBinding( VAO, VertexLoc, 0 );
 }
 
+glm::vec2 ObjectGL::getOctahedralEncoding(const glm::vec3& normal)
+// It projects the normal onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the upper half,
+// so that the normal is kept in the two coordinates of [-1, 1].
+{
+   const float l1_norm = std::abs( normal.x ) + std::abs( normal.y ) + std::abs( normal.z );
+   if (l1_norm == 0.0f) return glm::vec2(0.0f);
+
+   const glm::vec2 projected = glm::vec2(normal) / l1_norm;
+   if (normal.z >= 0.0f) return projected;
+   return {
+      (1.0f - std::abs( projected.y )) * (projected.x >= 0.0f ? 1.0f : -1.0f),
+      (1.0f - std::abs( projected.x )) * (projected.y >= 0.0f ? 1.0f : -1.0f)
+   };
+}
+
+void ObjectGL::setPositionBounds(
+   const std::vector<const GLfloat*>& vertex_sets,
+   GLsizei vertex_num,
+   int floats_per_vertex
+)
+// One bounding box covers all the vertex sets, so that the sets can be blended before the dequantization.
+{
+   glm::vec3 min_point(std::numeric_limits<float>::max());
+   glm::vec3 max_point(std::numeric_limits<float>::lowest());
+   for (const auto& vertices : vertex_sets) {
+      for (GLsizei i = 0; i < vertex_num; ++i) {
+         const glm::vec3 position = glm::make_vec3( vertices + static_cast<size_t>(i) * floats_per_vertex );
+         min_point = glm::min( min_point, position );
+         max_point = glm::max( max_point, position );
+      }
+   }
+   const bool is_empty = vertex_sets.empty() || vertex_num == 0;
+   PositionOffset = is_empty ? glm::vec3(0.0f) : min_point;
+   PositionScale = is_empty ? glm::vec3(0.0f) : max_point - min_point;
+}
+
+void ObjectGL::quantizeVertices(
+   GLushort* quantized,
+   const GLfloat* vertices,
+   GLsizei vertex_num,
+   bool normals_exist,
+   bool textures_exist
+) const
+// vertices is interleaved as x, y, z, (nx, ny, nz,) (s, t,) and a vertex gets 8 bytes for the position, 4 for the
+// normal and 4 for the texture coordinates, which is a half of the floats. The position is padded with an unused short,
+// so that every attribute and the stride stay 4-byte aligned for the fast vertex fetch.
+{
+   const int floats_per_vertex = 3 + (normals_exist ? 3 : 0) + (textures_exist ? 2 : 0);
+   const int shorts_per_vertex = 4 + (normals_exist ? 2 : 0) + (textures_exist ? 2 : 0);
+   for (GLsizei i = 0; i < vertex_num; ++i) {
+      const GLfloat* vertex = vertices + static_cast<size_t>(i) * floats_per_vertex;
+      GLushort* quantized_vertex = quantized + static_cast<size_t>(i) * shorts_per_vertex;
+      for (int axis = 0; axis < 3; ++axis) {
+         quantized_vertex[axis] = PositionScale[axis] > 0.0f ?
+            glm::packUnorm1x16( (vertex[axis] - PositionOffset[axis]) / PositionScale[axis] ) : 0;
+      }
+      quantized_vertex[3] = 0;
+      int f = 3, q = 4;
+      if (normals_exist) {
+         const glm::vec2 encoded = getOctahedralEncoding( glm::make_vec3( vertex + f ) );
+         quantized_vertex[q++] = glm::packSnorm1x16( encoded.x );
+         quantized_vertex[q++] = glm::packSnorm1x16( encoded.y );
+         f += 3;
+      }
+      if (textures_exist) {
+         quantized_vertex[q++] = glm::packHalf1x16( vertex[f] );
+         quantized_vertex[q] = glm::packHalf1x16( vertex[f + 1] );
+      }
+   }
+}
+
+void ObjectGL::setQuantizedObject(
+   GLenum draw_mode,
+   const GLfloat* vertices,
+   GLsizei vertex_num,
+   bool normals_exist,
+   bool textures_exist
+)
+{
+   DrawMode = draw_mode;
+   VerticesCount = vertex_num;
+   Format = VERTEX_FORMAT::QUANTIZED;
+   const int floats_per_vertex = 3 + (normals_exist ? 3 : 0) + (textures_exist ? 2 : 0);
+   const int shorts_per_vertex = 4 + (normals_exist ? 2 : 0) + (textures_exist ? 2 : 0);
+   setPositionBounds( { vertices }, vertex_num, floats_per_vertex );
+
+   std::vector<GLushort> quantized(static_cast<size_t>(vertex_num) * shorts_per_vertex);
+   quantizeVertices( quantized.data(), vertices, vertex_num, normals_exist, textures_exist );
+
+   const int n_bytes_per_vertex = shorts_per_vertex * sizeof( GLushort );
+   prepareVertexBuffer( n_bytes_per_vertex, quantized.data(), quantized.size() * sizeof( GLushort ) );
+   if (normals_exist) prepareNormal();
+   if (textures_exist) prepareTexture( normals_exist );
+}
+
 void ObjectGL::getSquareObject(
    std::vector<glm::vec3>& vertices,
    std::vector<glm::vec3>& normals,
@@ -296,6 +431,98 @@ void ObjectGL::setObject(
    addTexture( texture );
 }
 
+void ObjectGL::setObject(GLenum draw_mode, const GLfloat* vertices_and_normals, GLsizei vertex_num)
+// vertices_and_normals is interleaved as x, y, z, nx, ny, nz and uploaded as it is, e.g. from a memory-mapped file,
+// so DataBuffer is not kept for this object.
+{
+   DrawMode = draw_mode;
+   VerticesCount = vertex_num;
+   DataBuffer.clear();
+   const int n_bytes_per_vertex = 6 * sizeof( GLfloat );
+   prepareVertexBuffer( n_bytes_per_vertex, vertices_and_normals, static_cast<size_t>(vertex_num) * 6 );
+   prepareNormal();
+}
+
+void ObjectGL::setObject(
+   GLenum draw_mode,
+   const std::vector<GLfloat>& vertices_and_normals,
+   const std::vector<GLuint>& indices,
+   VERTEX_FORMAT format
+)
+// It is drawn by glDrawElements() with getIndexNum() indices of GL_UNSIGNED_INT.
+{
+   const auto vertex_num = static_cast<GLsizei>(vertices_and_normals.size() / 6);
+   if (format == VERTEX_FORMAT::QUANTIZED) {
+      DataBuffer.clear();
+      setQuantizedObject( draw_mode, vertices_and_normals.data(), vertex_num, true, false );
+   }
+   else setObject( draw_mode, vertices_and_normals.data(), vertex_num );
+   IndicesCount = static_cast<GLsizei>(indices.size());
+   glCreateBuffers( 1, &EBO );
+   glNamedBufferStorage( EBO, sizeof( GLuint ) * indices.size(), indices.data(), GL_DYNAMIC_STORAGE_BIT );
+   glVertexArrayElementBuffer( VAO, EBO );
+}
+
+void ObjectGL::setKeyframeObject(
+   GLenum draw_mode,
+   const std::vector<const GLfloat*>& keyframes,
+   GLsizei vertex_num,
+   VERTEX_FORMAT format
+)
+// Every keyframe is interleaved as x, y, z, nx, ny, nz and has the same number of vertices. The keyframes are laid out
+// back to back in one buffer, and binding 0 and 1 point at the keyframes to be blended by setKeyframes(). The quantized
+// keyframes share one bounding box, so the blended position is dequantized once.
+{
+   DrawMode = draw_mode;
+   VerticesCount = vertex_num;
+   KeyframeNum = static_cast<int>(keyframes.size());
+   Format = format;
+   DataBuffer.clear();
+   const int n_bytes_per_vertex = getKeyframeVertexSize();
+   const auto keyframe_size = static_cast<GLsizeiptr>(vertex_num) * n_bytes_per_vertex;
+   if (Format == VERTEX_FORMAT::QUANTIZED) {
+      setPositionBounds( keyframes, vertex_num, 6 );
+      const size_t shorts_per_keyframe = static_cast<size_t>(keyframe_size) / sizeof( GLushort );
+      std::vector<GLushort> quantized(keyframes.size() * shorts_per_keyframe);
+      for (size_t k = 0; k < keyframes.size(); ++k) {
+         quantizeVertices( quantized.data() + k * shorts_per_keyframe, keyframes[k], vertex_num, true, false );
+      }
+      prepareVertexBuffer( n_bytes_per_vertex, quantized.data(), quantized.size() * sizeof( GLushort ) );
+      glVertexArrayAttribFormat( VAO, NextVertexLoc, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 );
+      glVertexArrayAttribFormat( VAO, NextNormalLoc, 2, GL_SHORT, GL_TRUE, 4 * sizeof( GLushort ) );
+   }
+   else {
+      prepareVertexBuffer( n_bytes_per_vertex, static_cast<const GLvoid*>(nullptr), keyframes.size() * keyframe_size );
+      for (size_t k = 0; k < keyframes.size(); ++k) {
+         glNamedBufferSubData( VBO, static_cast<GLintptr>(k) * keyframe_size, keyframe_size, keyframes[k] );
+      }
+      glVertexArrayAttribFormat( VAO, NextVertexLoc, 3, GL_FLOAT, GL_FALSE, 0 );
+      glVertexArrayAttribFormat( VAO, NextNormalLoc, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( GLfloat ) );
+   }
+   prepareNormal();
+   glEnableVertexArrayAttrib( VAO, NextVertexLoc );
+   glVertexArrayAttribBinding( VAO, NextVertexLoc, 1 );
+   glEnableVertexArrayAttrib( VAO, NextNormalLoc );
+   glVertexArrayAttribBinding( VAO, NextNormalLoc, 1 );
+   setKeyframes( 0, 0 );
+}
+
+void ObjectGL::setKeyframes(int keyframe, int next_keyframe) const
+{
+   const int n_bytes_per_vertex = getKeyframeVertexSize();
+   const auto keyframe_size = static_cast<GLintptr>(VerticesCount) * n_bytes_per_vertex;
+   glVertexArrayVertexBuffer( VAO, 0, VBO, keyframe * keyframe_size, n_bytes_per_vertex );
+   glVertexArrayVertexBuffer( VAO, 1, VBO, next_keyframe * keyframe_size, n_bytes_per_vertex );
+}
+
+GLsizeiptr ObjectGL::getBufferSize() const
+{
+   GLint64 vertex_buffer_size = 0, index_buffer_size = 0;
+   if (VBO != 0) glGetNamedBufferParameteri64v( VBO, GL_BUFFER_SIZE, &vertex_buffer_size );
+   if (EBO != 0) glGetNamedBufferParameteri64v( EBO, GL_BUFFER_SIZE, &index_buffer_size );
+   return static_cast<GLsizeiptr>(vertex_buffer_size + index_buffer_size);
+}
+
 void ObjectGL::setObject(
    GLenum draw_mode,
    const std::vector<glm::vec3>& vertices,
@@ -325,7 +552,8 @@ void ObjectGL::setObject(
    GLenum draw_mode,
    const std::vector<glm::vec3>& vertices,
    const std::vector<glm::vec3>& normals,
-   const std::vector<glm::vec2>& textures
+   const std::vector<glm::vec2>& textures,
+   VERTEX_FORMAT format
 )
 {
    DrawMode = draw_mode;
@@ -342,6 +570,12 @@ void ObjectGL::setObject(
       DataBuffer.push_back( textures[i].y );
       VerticesCount++;
    }
+   if (format == VERTEX_FORMAT::QUANTIZED) {
+      // The floats are not kept, so the vertices of this object cannot be updated or replaced.
+      setQuantizedObject( draw_mode, DataBuffer.data(), VerticesCount, true, true );
+      DataBuffer.clear();
+      return;
+   }
    const int n_bytes_per_vertex = 8 * sizeof( GLfloat );
    prepareVertexBuffer( n_bytes_per_vertex );
    prepareNormal();
@@ -384,16 +618,20 @@ void ObjectGL::setSquareObject(
 
 void ObjectGL::transferUniformsToShader(const ShaderGL* shader)
 {
+   glUniform3fv( shader->getPositionScaleLocation(), 1, &PositionScale[0] );
+   glUniform3fv( shader->getPositionOffsetLocation(), 1, &PositionOffset[0] );
+   glUniform1i( shader->getOctahedralNormalUsageLocation(), Format == VERTEX_FORMAT::QUANTIZED ? 1 : 0 );
    glUniform4fv( shader->getMaterialEmissionLocation(), 1, &EmissionColor[0] );
    glUniform4fv( shader->getMaterialAmbientLocation(), 1, &AmbientReflectionColor[0] );
    glUniform4fv( shader->getMaterialDiffuseLocation(), 1, &DiffuseReflectionColor[0] );
    glUniform4fv( shader->getMaterialSpecularLocation(), 1, &SpecularReflectionColor[0] );
    glUniform1f( shader->getMaterialSpecularExponentLocation(), SpecularReflectionExponent );
+   glUniform1f( shader->getMaterialRoughnessLocation(), Roughness );
 }
 
 void ObjectGL::updateDataBuffer(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals)
 {
-   assert( VBO != 0 );
+   assert( VBO != 0 && Format == VERTEX_FORMAT::FLOAT32 );
 
    VerticesCount = 0;
    DataBuffer.clear();
@@ -415,7 +653,7 @@ void ObjectGL::updateDataBuffer(
    const std::vector<glm::vec2>& textures
 )
 {
-   assert( VBO != 0 );
+   assert( VBO != 0 && Format == VERTEX_FORMAT::FLOAT32 );
 
    VerticesCount = 0;
    DataBuffer.clear();
@@ -439,7 +677,7 @@ void ObjectGL::replaceVertices(
    bool textures_exist
 )
 {
-   assert( VBO != 0 );
+   assert( VBO != 0 && Format == VERTEX_FORMAT::FLOAT32 );
 
    VerticesCount = 0;
    int step = 3;
@@ -460,7 +698,7 @@ void ObjectGL::replaceVertices(
    bool textures_exist
 )
 {
-   assert( VBO != 0 );
+   assert( VBO != 0 && Format == VERTEX_FORMAT::FLOAT32 );
 
    VerticesCount = 0;
    int step = 3;
@@ -0,0 +1,108 @@
+#include "OffscreenContext.h"
+
+#ifndef _WIN32
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef _WIN32
+OffscreenContextGL::OffscreenContextGL() : Window( nullptr )
+{
+}
+#else
+OffscreenContextGL::OffscreenContextGL() : Display( nullptr ), Context( nullptr )
+{
+}
+#endif
+
+OffscreenContextGL::~OffscreenContextGL()
+{
+   destroy();
+}
+
+#ifdef _WIN32
+bool OffscreenContextGL::create(int major_version, int minor_version)
+{
+   destroy();
+   if (!glfwInit()) {
+      std::cerr << "Cannot Initialize OpenGL...\n";
+      return false;
+   }
+   glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, major_version );
+   glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, minor_version );
+   glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+   glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+   Window = glfwCreateWindow( 1, 1, "Offscreen", nullptr, nullptr );
+   if (Window == nullptr) {
+      std::cerr << "Could not create an invisible window for the offscreen context.\n";
+      return false;
+   }
+   glfwMakeContextCurrent( Window );
+   if (!gladLoadGLLoader( (GLADloadproc)glfwGetProcAddress )) {
+      std::cerr << "Failed to initialize GLAD\n";
+      destroy();
+      return false;
+   }
+   return true;
+}
+
+void OffscreenContextGL::destroy()
+{
+   if (Window != nullptr) glfwDestroyWindow( Window );
+   Window = nullptr;
+}
+#else
+bool OffscreenContextGL::create(int major_version, int minor_version)
+// The surfaceless context has no config and no surface, as EGL_KHR_no_config_context and EGL_KHR_surfaceless_context.
+{
+   destroy();
+   const auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress( "eglGetPlatformDisplayEXT" ));
+   EGLDisplay display = get_platform_display == nullptr ?
+      EGL_NO_DISPLAY : get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+   if (display == EGL_NO_DISPLAY || !eglInitialize( display, nullptr, nullptr )) {
+      std::cerr << "Could not initialize the surfaceless EGL display.\n";
+      return false;
+   }
+   Display = display;
+
+   const EGLint context_attributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, major_version,
+      EGL_CONTEXT_MINOR_VERSION, minor_version,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE
+   };
+   EGLContext context = EGL_NO_CONTEXT;
+   if (eglBindAPI( EGL_OPENGL_API )) {
+      context = eglCreateContext( display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes );
+   }
+   if (context == EGL_NO_CONTEXT || !eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, context )) {
+      std::cerr << "Could not create an OpenGL " << major_version << "." << minor_version
+         << " core profile context on the surfaceless EGL display. (error 0x" << std::hex << eglGetError() << std::dec
+         << ")\n";
+      if (context != EGL_NO_CONTEXT) eglDestroyContext( display, context );
+      destroy();
+      return false;
+   }
+   Context = context;
+
+   if (!gladLoadGLLoader( reinterpret_cast<GLADloadproc>(eglGetProcAddress) )) {
+      std::cerr << "Failed to initialize GLAD\n";
+      destroy();
+      return false;
+   }
+   return true;
+}
+
+void OffscreenContextGL::destroy()
+{
+   if (Display == nullptr) return;
+
+   eglMakeCurrent( Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+   if (Context != nullptr) eglDestroyContext( Display, Context );
+   eglTerminate( Display );
+   Display = nullptr;
+   Context = nullptr;
+}
+#endif
\ No newline at end of file
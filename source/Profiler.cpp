@@ -0,0 +1,264 @@
+#include "Profiler.h"
+
+#include <numeric>
+
+ProfilerGL::ProfilerGL() : Enabled( false ), InFrame( false ), DroppedResultNum( 0 )
+{
+}
+
+ProfilerGL::~ProfilerGL()
+{
+   for (auto& slot : QueryRing) {
+      for (auto& queries : slot.Queries) {
+         if (!queries.empty()) glDeleteQueries( static_cast<GLsizei>(queries.size()), queries.data() );
+      }
+   }
+}
+
+const char* ProfilerGL::getStageName(STAGE stage)
+{
+   switch (stage) {
+      case STAGE::UPDATE: return "update";
+      case STAGE::RENDER: return "render";
+      case STAGE::DRAW_ENVIRONMENT: return "draw_environment";
+      case STAGE::DRAW_MOVING_TIGER: return "draw_moving_tiger";
+      case STAGE::DRAW_COW: return "draw_cow";
+      default: return "";
+   }
+}
+
+int ProfilerGL::getGPUStageIndex(STAGE stage)
+{
+   const int index = static_cast<int>(stage) - static_cast<int>(STAGE::DRAW_ENVIRONMENT);
+   return index >= 0 && index < GPUStageNum ? index : -1;
+}
+
+double ProfilerGL::getPercentile(const std::vector<double>& sorted_values, double percent)
+{
+   const auto n = static_cast<int>(sorted_values.size());
+   const int rank = std::clamp( static_cast<int>(std::ceil( percent * 0.01 * n )), 1, n );
+   return sorted_values[rank - 1];
+}
+
+std::vector<double> ProfilerGL::getSortedMeasuredValues(const Column& column)
+{
+   std::vector<double> values;
+   std::copy_if(
+      column.Values.begin(), column.Values.end(), std::back_inserter( values ),
+      [](double value) { return value >= 0.0; }
+   );
+   std::sort( values.begin(), values.end() );
+   return values;
+}
+
+void ProfilerGL::setEnabled(bool enabled)
+{
+   if (Enabled == enabled) return;
+
+   if (enabled) {
+      for (auto& slot : QueryRing) slot.Pending = false;
+      Frames.clear();
+      DroppedResultNum = 0;
+      Enabled = true;
+   }
+   else {
+      if (InFrame) endFrame();
+      for (auto& slot : QueryRing) collectResults( slot, true );
+      Enabled = false;
+   }
+}
+
+void ProfilerGL::collectResults(QuerySlot& slot, bool waits)
+// A result which is not ready after QueryRingSize frames is dropped instead of waited for, unless it waits. The runs of
+// a pass are dropped together, so a GPU time is never the sum of only some of them.
+{
+   if (!slot.Pending) return;
+
+   slot.Pending = false;
+   FrameRecord& frame = Frames[slot.FrameIndex];
+   for (int i = 0; i < GPUStageNum; ++i) {
+      const size_t issued_num = slot.IssuedNums[i];
+      if (issued_num == 0) continue;
+
+      if (!waits) {
+         bool available = true;
+         for (size_t q = 0; q < issued_num && available; ++q) {
+            GLint is_available = 0;
+            glGetQueryObjectiv( slot.Queries[i][q], GL_QUERY_RESULT_AVAILABLE, &is_available );
+            available = is_available != GL_FALSE;
+         }
+         if (!available) {
+            DroppedResultNum++;
+            continue;
+         }
+      }
+      GLuint64 total_elapsed = 0;
+      for (size_t q = 0; q < issued_num; ++q) {
+         GLuint64 elapsed = 0;
+         glGetQueryObjectui64v( slot.Queries[i][q], GL_QUERY_RESULT, &elapsed );
+         total_elapsed += elapsed;
+      }
+      frame.GPUTimes[i] = static_cast<double>(total_elapsed) * 1e-6;
+   }
+}
+
+void ProfilerGL::beginFrame()
+{
+   if (!Enabled) return;
+   if (InFrame) endFrame();
+
+   QuerySlot& slot = QueryRing[Frames.size() % QueryRingSize];
+   collectResults( slot, false );
+   slot.FrameIndex = Frames.size();
+   slot.IssuedNums.fill( 0 );
+   Frames.emplace_back();
+   InFrame = true;
+   FrameStart = std::chrono::steady_clock::now();
+}
+
+void ProfilerGL::endFrame()
+{
+   if (!Enabled || !InFrame) return;
+
+   Frames.back().FrameTime =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - FrameStart).count();
+   QuerySlot& slot = QueryRing[(Frames.size() - 1) % QueryRingSize];
+   slot.Pending = std::any_of( slot.IssuedNums.begin(), slot.IssuedNums.end(), [](size_t num) { return num > 0; } );
+   InFrame = false;
+}
+
+void ProfilerGL::begin(STAGE stage)
+{
+   if (!InFrame) return;
+
+   const int gpu_stage = getGPUStageIndex( stage );
+   if (gpu_stage >= 0) {
+      QuerySlot& slot = QueryRing[(Frames.size() - 1) % QueryRingSize];
+      std::vector<GLuint>& queries = slot.Queries[gpu_stage];
+      size_t& issued_num = slot.IssuedNums[gpu_stage];
+      if (issued_num == queries.size()) {
+         GLuint query;
+         glCreateQueries( GL_TIME_ELAPSED, 1, &query );
+         queries.emplace_back( query );
+      }
+      glBeginQuery( GL_TIME_ELAPSED, queries[issued_num++] );
+   }
+   StageStarts[static_cast<int>(stage)] = std::chrono::steady_clock::now();
+}
+
+void ProfilerGL::end(STAGE stage)
+{
+   if (!InFrame) return;
+
+   const auto index = static_cast<int>(stage);
+   const double elapsed =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StageStarts[index]).count();
+   double& cpu_time = Frames.back().CPUTimes[index];
+   cpu_time = std::max( cpu_time, 0.0 ) + elapsed;
+   if (getGPUStageIndex( stage ) >= 0) glEndQuery( GL_TIME_ELAPSED );
+}
+
+void ProfilerGL::getColumns(std::vector<Column>& columns) const
+{
+   columns.clear();
+   columns.push_back( { "frame_ms", {} } );
+   for (int s = 0; s < StageNum; ++s) {
+      columns.push_back( { std::string(getStageName( static_cast<STAGE>(s) )) + "_cpu_ms", {} } );
+   }
+   for (int g = 0; g < GPUStageNum; ++g) {
+      const auto stage = static_cast<STAGE>(static_cast<int>(STAGE::DRAW_ENVIRONMENT) + g);
+      columns.push_back( { std::string(getStageName( stage )) + "_gpu_ms", {} } );
+   }
+
+   for (const auto& frame : Frames) {
+      size_t c = 0;
+      columns[c++].Values.emplace_back( frame.FrameTime );
+      for (const auto& cpu_time : frame.CPUTimes) columns[c++].Values.emplace_back( cpu_time );
+      for (const auto& gpu_time : frame.GPUTimes) columns[c++].Values.emplace_back( gpu_time );
+   }
+}
+
+void ProfilerGL::printReport() const
+{
+   std::vector<Column> columns;
+   getColumns( columns );
+
+   std::cout << "****************************************************************\n";
+   std::cout << " - Profiled Frames: " << Frames.size() << " (" << DroppedResultNum << " GPU results not ready in "
+      << QueryRingSize << " frames)\n";
+   for (const auto& column : columns) {
+      const std::vector<double> values = getSortedMeasuredValues( column );
+      if (values.empty()) continue;
+
+      const double mean = std::accumulate( values.begin(), values.end(), 0.0 ) / static_cast<double>(values.size());
+      std::cout << " - " << std::setw( 24 ) << std::left << column.Name << std::right << ": " << std::fixed
+         << std::setprecision( 3 ) << "mean " << mean << ", p50 " << getPercentile( values, 50.0 )
+         << ", p95 " << getPercentile( values, 95.0 ) << ", p99 " << getPercentile( values, 99.0 )
+         << " (" << values.size() << " frames)\n";
+      std::cout.unsetf( std::ios::floatfield );
+   }
+   std::cout << "****************************************************************\n\n";
+}
+
+bool ProfilerGL::writeCSV(const std::string& file_path) const
+{
+   std::ofstream file(file_path);
+   if (!file.is_open()) {
+      std::cerr << "Could not write profile " << file_path << "\n";
+      return false;
+   }
+
+   std::vector<Column> columns;
+   getColumns( columns );
+   file << "frame";
+   for (const auto& column : columns) file << "," << column.Name;
+   file << "\n" << std::fixed << std::setprecision( 6 );
+   for (size_t i = 0; i < Frames.size(); ++i) {
+      file << i;
+      for (const auto& column : columns) {
+         file << ",";
+         if (column.Values[i] >= 0.0) file << column.Values[i];
+      }
+      file << "\n";
+   }
+   return static_cast<bool>(file);
+}
+
+bool ProfilerGL::writeJSON(const std::string& file_path) const
+// The stages which did not run are null in the frames and are left out of the summary.
+{
+   std::ofstream file(file_path);
+   if (!file.is_open()) {
+      std::cerr << "Could not write profile " << file_path << "\n";
+      return false;
+   }
+
+   std::vector<Column> columns;
+   getColumns( columns );
+   file << std::fixed << std::setprecision( 6 );
+   file << "{\n  \"frame_num\": " << Frames.size() << ",\n  \"dropped_gpu_results\": " << DroppedResultNum
+      << ",\n  \"summary\": {";
+   bool is_first = true;
+   for (const auto& column : columns) {
+      const std::vector<double> values = getSortedMeasuredValues( column );
+      if (values.empty()) continue;
+
+      const double mean = std::accumulate( values.begin(), values.end(), 0.0 ) / static_cast<double>(values.size());
+      file << (is_first ? "\n" : ",\n") << "    \"" << column.Name << "\": { \"count\": " << values.size()
+         << ", \"mean\": " << mean << ", \"p50\": " << getPercentile( values, 50.0 )
+         << ", \"p95\": " << getPercentile( values, 95.0 ) << ", \"p99\": " << getPercentile( values, 99.0 ) << " }";
+      is_first = false;
+   }
+   file << "\n  },\n  \"frames\": [";
+   for (size_t i = 0; i < Frames.size(); ++i) {
+      file << (i == 0 ? "\n" : ",\n") << "    { \"frame\": " << i;
+      for (const auto& column : columns) {
+         file << ", \"" << column.Name << "\": ";
+         if (column.Values[i] >= 0.0) file << column.Values[i];
+         else file << "null";
+      }
+      file << " }";
+   }
+   file << "\n  ]\n}\n";
+   return static_cast<bool>(file);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "RenderScript.h"
+
+bool RenderScript::load(std::vector<Frame>& frames, const std::string& script_path)
+{
+   frames.clear();
+   std::ifstream file(script_path);
+   if (!file.is_open()) {
+      std::cerr << "Could not open render script " << script_path << "\n";
+      return false;
+   }
+
+   std::string line;
+   for (int line_number = 1; std::getline( file, line ); ++line_number) {
+      const size_t first = line.find_first_not_of( " \t\r" );
+      if (first == std::string::npos || line[first] == '#') continue;
+
+      Frame frame;
+      std::string object;
+      std::istringstream fields(line);
+      fields >> frame.CameraPosition.x >> frame.CameraPosition.y >> frame.CameraPosition.z
+         >> frame.CameraTarget.x >> frame.CameraTarget.y >> frame.CameraTarget.z
+         >> object >> frame.TigerIndex >> frame.KeyframeBlend >> frame.TigerRotationAngle;
+      if (fields.fail() || (object != "cow" && object != "tiger")) {
+         std::cerr << "Could not parse line " << line_number << " of render script " << script_path << "\n";
+         frames.clear();
+         return false;
+      }
+      frame.DrawMovingObject = object == "tiger";
+      frame.TigerIndex = std::max( frame.TigerIndex, 0 );
+      frame.KeyframeBlend = std::clamp( frame.KeyframeBlend, 0.0f, 1.0f );
+      frames.emplace_back( frame );
+   }
+   if (frames.empty()) {
+      std::cerr << "Render script " << script_path << " has no frame.\n";
+      return false;
+   }
+   return true;
+}
\ No newline at end of file
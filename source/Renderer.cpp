@@ -1,17 +1,34 @@
 #include "Renderer.h"
 
-RendererGL::RendererGL() : 
-   Window( nullptr ), DrawMovingObject( false ), FrameWidth( 1920 ), FrameHeight( 1080 ), ActivatedLightIndex( 0 ),
-   TigerIndex( 0 ), TigerRotationAngle( 0 ), EnvironmentRadius( 10.0f ), ClickedPoint( -1, -1 ),
+#include <filesystem>
+#include <numeric>
+
+RendererGL::RendererGL(bool offscreen, int frame_width, int frame_height) :
+   OffscreenContext( offscreen ? std::make_unique<OffscreenContextGL>() : nullptr ), Window( nullptr ), FBO( 0 ),
+   ColorBuffer( 0 ), DepthBuffer( 0 ), DrawMovingObject( false ), FrameWidth( std::max( frame_width, 1 ) ),
+   FrameHeight( std::max( frame_height, 1 ) ), ActivatedLightIndex( 0 ),
+   TigerIndex( 0 ), KeyframeBlend( 0.0f ), TigerRotationAngle( 0 ), EnvironmentRadius( 10.0f ),
+   ReflectionMode( REFLECTION_MODE::CUBEMAP ), LightingMode( LIGHTING_MODE::POINT_LIGHTS ), ClickedPoint( -1, -1 ),
    MainCamera( std::make_unique<CameraGL>() ), ObjectShader( std::make_unique<ShaderGL>() ),
    EnvironmentShader( std::make_unique<ShaderGL>() ), EnvironmentObject( std::make_unique<ObjectGL>() ),
-   CowObject( std::make_unique<ObjectGL>() ), Lights( std::make_unique<LightGL>() ),
-   LightFinder( std::make_unique<LightPosition>() ), LongitudeLatitudeMapper( std::make_unique<LongitudeLatitudeMapping>() )
+   CowObject( std::make_unique<ObjectGL>() ), MovingTigerObject( std::make_unique<ObjectGL>() ),
+   Lights( std::make_unique<LightGL>() ),
+   TextureCache( std::make_unique<TextureCacheGL>() ), IrradianceCoefficients{},
+   LightFinder( std::make_unique<LightPosition>() ), LongitudeLatitudeMapper( std::make_unique<LongitudeLatitudeMapping>() ),
+   FisheyeConverter( std::make_unique<FisheyeConverterGL>() ), LightEstimator( std::make_unique<LightEstimatorGL>() ),
+   Profiler( std::make_unique<ProfilerGL>() ), RecordingStartTime( 0.0 )
 {
    Renderer = this;
 
    initialize();
-   printOpenGLInformation();
+   if (GLVersion.major > 0) printOpenGLInformation();
+}
+
+RendererGL::~RendererGL()
+{
+   if (FBO != 0) glDeleteFramebuffers( 1, &FBO );
+   if (ColorBuffer != 0) glDeleteRenderbuffers( 1, &ColorBuffer );
+   if (DepthBuffer != 0) glDeleteRenderbuffers( 1, &DepthBuffer );
 }
 
 void RendererGL::printOpenGLInformation()
@@ -25,27 +42,34 @@ void RendererGL::printOpenGLInformation()
 }
 
 void RendererGL::initialize()
+// The offscreen context asks for OpenGL 4.5, which is all the renderer needs and what Mesa llvmpipe supports.
 {
-   if (!glfwInit()) {
-      std::cout << "Cannot Initialize OpenGL...\n";
-      return;
+   if (OffscreenContext != nullptr) {
+      if (!OffscreenContext->create( 4, 5 ) || !setOffscreenFramebuffer()) return;
    }
-   glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
-   glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 6 );
-   glfwWindowHint( GLFW_DOUBLEBUFFER, GLFW_TRUE );
-   glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+   else {
+      if (!glfwInit()) {
+         std::cout << "Cannot Initialize OpenGL...\n";
+         return;
+      }
+      glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
+      glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 6 );
+      glfwWindowHint( GLFW_DOUBLEBUFFER, GLFW_TRUE );
+      glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
 
-   Window = glfwCreateWindow( FrameWidth, FrameHeight, "Main Camera", nullptr, nullptr );
-   glfwMakeContextCurrent( Window );
+      Window = glfwCreateWindow( FrameWidth, FrameHeight, "Main Camera", nullptr, nullptr );
+      glfwMakeContextCurrent( Window );
 
-   if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-      std::cout << "Failed to initialize GLAD" << std::endl;
-      return;
+      if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+         std::cout << "Failed to initialize GLAD" << std::endl;
+         return;
+      }
+
+      registerCallbacks();
    }
-   
-   registerCallbacks();
-   
+
    glEnable( GL_DEPTH_TEST );
+   glEnable( GL_TEXTURE_CUBE_MAP_SEAMLESS );
    glClearColor( 1.0f, 1.0f, 1.0f, 1.0f );
 
    MainCamera->updateWindowSize( FrameWidth, FrameHeight );
@@ -61,6 +85,29 @@ void RendererGL::initialize()
    );
 }
 
+bool RendererGL::setOffscreenFramebuffer()
+{
+   if (FBO != 0) glDeleteFramebuffers( 1, &FBO );
+   if (ColorBuffer != 0) glDeleteRenderbuffers( 1, &ColorBuffer );
+   if (DepthBuffer != 0) glDeleteRenderbuffers( 1, &DepthBuffer );
+
+   glCreateRenderbuffers( 1, &ColorBuffer );
+   glNamedRenderbufferStorage( ColorBuffer, GL_RGBA8, FrameWidth, FrameHeight );
+   glCreateRenderbuffers( 1, &DepthBuffer );
+   glNamedRenderbufferStorage( DepthBuffer, GL_DEPTH_COMPONENT24, FrameWidth, FrameHeight );
+
+   glCreateFramebuffers( 1, &FBO );
+   glNamedFramebufferRenderbuffer( FBO, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorBuffer );
+   glNamedFramebufferRenderbuffer( FBO, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DepthBuffer );
+   if (glCheckNamedFramebufferStatus( FBO, GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE) {
+      std::cerr << "The offscreen framebuffer is not complete.\n";
+      return false;
+   }
+   glBindFramebuffer( GL_FRAMEBUFFER, FBO );
+   glViewport( 0, 0, FrameWidth, FrameHeight );
+   return true;
+}
+
 void RendererGL::error(int error, const char* description) const
 {
    puts( description );
@@ -85,6 +132,11 @@ void RendererGL::keyboard(GLFWwindow* window, int key, int scancode, int action,
 {
    if (action != GLFW_PRESS) return;
 
+   // The camera is recorded by its states, so only the keys which change the scene are recorded.
+   const bool changes_scene = key == GLFW_KEY_L || key == GLFW_KEY_ENTER || key == GLFW_KEY_SPACE ||
+      key == GLFW_KEY_R || key == GLFW_KEY_H;
+   if (RecordedPath != nullptr && changes_scene) RecordedPath->addKey( glfwGetTime() - RecordingStartTime, key );
+
    switch (key) {
       case GLFW_KEY_UP:
          MainCamera->moveForward();
@@ -121,10 +173,27 @@ void RendererGL::keyboard(GLFWwindow* window, int key, int scancode, int action,
       case GLFW_KEY_SPACE:
          DrawMovingObject = !DrawMovingObject;
          break;
+      case GLFW_KEY_R:
+         ReflectionMode =
+            ReflectionMode == REFLECTION_MODE::CUBEMAP ? REFLECTION_MODE::ANALYTIC : REFLECTION_MODE::CUBEMAP;
+         std::cout << "Reflection: " << (ReflectionMode == REFLECTION_MODE::CUBEMAP ? "Cube Map\n" : "Analytic\n");
+         break;
+      case GLFW_KEY_H:
+         LightingMode = LightingMode == LIGHTING_MODE::POINT_LIGHTS ?
+            LIGHTING_MODE::SPHERICAL_HARMONICS : LIGHTING_MODE::POINT_LIGHTS;
+         std::cout << "Lighting: "
+            << (LightingMode == LIGHTING_MODE::POINT_LIGHTS ? "Point Lights\n" : "Spherical Harmonics\n");
+         break;
       case GLFW_KEY_P: {
          const glm::vec3 pos = MainCamera->getCameraPosition();
          std::cout << "Camera Position: " << pos.x << ", " << pos.y << ", " << pos.z << "\n";
       } break;
+      case GLFW_KEY_T:
+         toggleProfiling();
+         break;
+      case GLFW_KEY_C:
+         toggleCameraPathRecording();
+         break;
       case GLFW_KEY_Q:
       case GLFW_KEY_ESCAPE:
          cleanupWrapper( window );
@@ -215,7 +284,7 @@ void RendererGL::registerCallbacks() const
    glfwSetFramebufferSizeCallback( Window, reshapeWrapper );
 }
 
-void RendererGL::setEnvironmentObject(const cv::Mat& texture)
+void RendererGL::setEnvironmentObject(const TextureCacheGL::Handle& texture)
 {
    const std::string sample_directory_path = std::string(CMAKE_SOURCE_DIR) + "/samples";
    const std::string object_path = sample_directory_path + "/objects/hemisphere.glbin";
@@ -245,81 +314,154 @@ void RendererGL::setEnvironmentObject(const cv::Mat& texture)
       );
    }
 
-   EnvironmentObject->setObject( GL_TRIANGLES, hemisphere_vertices, texture );
+   EnvironmentObject->setObject( GL_TRIANGLES, hemisphere_vertices );
+   EnvironmentObject->addTexture( texture );
    EnvironmentObject->setDiffuseReflectionColor( { 1.0f, 1.0f, 1.0f, 1.0f } );
 }
 
-void RendererGL::setMovingTigerObjects(const cv::Mat& texture)
+void RendererGL::setMovingTigerObject(const TextureCacheGL::Handle& texture)
 {
-   MovingTigerObjects.clear();
    const std::string sample_directory_path = std::string(CMAKE_SOURCE_DIR) + "/samples";
    const std::string object_path = sample_directory_path + "/objects/tiger";
+   std::vector<MeshCache> tigers(12);
+   std::vector<const GLfloat*> keyframes;
    for (int t = 0; t < 12; ++t) {
-      std::ifstream file(object_path + std::to_string( t ) + ".txt");
-      int polygon_num;
-      file >> polygon_num;
-
-      const int vertex_num = polygon_num * 3;
-      std::vector<glm::vec3> tiger_vertices(vertex_num);
-      std::vector<glm::vec3> tiger_normals(vertex_num);
-      std::vector<glm::vec2> tiger_textures_not_used(vertex_num);
-      for (int i = 0; i < polygon_num; ++i) {
-         int triangle_vertex_num;
-         file >> triangle_vertex_num;
-         for (int v = 0; v < triangle_vertex_num; ++v) {
-            const int index = i * triangle_vertex_num + v;
-            file >> tiger_vertices[index].x >> tiger_vertices[index].y >> tiger_vertices[index].z;
-            file >> tiger_normals[index].x >> tiger_normals[index].y >> tiger_normals[index].z;
-            file >> tiger_textures_not_used[index].x >> tiger_textures_not_used[index].y;
-         }
+      // Each vertex of the text model has a position, a normal and the texture coordinates which are not used.
+      if (!tigers[t].load( object_path + std::to_string( t ) + ".txt", 8, 6 )) return;
+      if (tigers[t].getVertexNum() != tigers[0].getVertexNum()) {
+         std::cerr << "The tiger keyframes should have the same number of vertices.\n";
+         return;
       }
-      file.close();
-
-      MovingTigerObjects.emplace_back( std::make_unique<ObjectGL>() );
-      MovingTigerObjects[t]->setObject( GL_TRIANGLES, tiger_vertices, tiger_normals, texture );
-      MovingTigerObjects[t]->setDiffuseReflectionColor( { 1.0f, 1.0f, 1.0f, 1.0f } );
+      keyframes.emplace_back( tigers[t].getVertexData() );
    }
+
+   MovingTigerObject->setKeyframeObject(
+      GL_TRIANGLES, keyframes, tigers[0].getVertexNum(), ObjectGL::VERTEX_FORMAT::QUANTIZED
+   );
+   MovingTigerObject->addTexture( texture );
+   MovingTigerObject->setDiffuseReflectionColor( { 1.0f, 1.0f, 1.0f, 1.0f } );
 }
 
-void RendererGL::setCowObject(const cv::Mat& texture)
+void RendererGL::setCowObject(const TextureCacheGL::Handle& texture)
 {
    const std::string sample_directory_path = std::string(CMAKE_SOURCE_DIR) + "/samples";
    const std::string object_path = sample_directory_path + "/objects/cow.txt";
-   std::ifstream file(object_path);
-   int polygon_num;
-   file >> polygon_num;
-
-   const int vertex_num = polygon_num * 3;
-   std::vector<glm::vec3> cow_vertices(vertex_num);
-   std::vector<glm::vec3> cow_normals(vertex_num);
-   for (int i = 0; i < polygon_num; ++i) {
-      int triangle_vertex_num;
-      file >> triangle_vertex_num;
-      for (int v = 0; v < triangle_vertex_num; ++v) {
-         const int index = i * triangle_vertex_num + v;
-         file >> cow_vertices[index].x >> cow_vertices[index].y >> cow_vertices[index].z;
-         file >> cow_normals[index].x >> cow_normals[index].y >> cow_normals[index].z;
-      }
-   }
-   file.close();
+   MeshCache cow;
+   if (!cow.load( object_path, 6, 6 )) return;
+
+   std::vector<GLfloat> cow_vertices;
+   std::vector<GLuint> cow_indices;
+   MeshOptimizer::deduplicateVertices( cow_vertices, cow_indices, cow.getVertexData(), cow.getVertexNum(), 6 );
+   const auto unique_vertex_num = static_cast<int>(cow_vertices.size() / 6);
+   const float acmr_before_reordering = MeshOptimizer::getACMR( cow_indices, unique_vertex_num );
+   MeshOptimizer::reorderForVertexCache( cow_indices, unique_vertex_num );
+   std::cout << ">> Cow: " << cow.getVertexNum() << " vertices are indexed into " << unique_vertex_num
+      << " unique vertices. (ACMR: " << MeshOptimizer::getACMR( cow_indices, unique_vertex_num )
+      << ", " << acmr_before_reordering << " before reordering, 3 without indices)\n\n";
 
-   CowObject->setObject( GL_TRIANGLES, cow_vertices, cow_normals, texture );
+   CowObject->setObject( GL_TRIANGLES, cow_vertices, cow_indices, ObjectGL::VERTEX_FORMAT::QUANTIZED );
+   CowObject->addTexture( texture );
    CowObject->setDiffuseReflectionColor( { 1.0f, 1.0f, 1.0f, 1.0f } );
+   CowObject->setRoughness( 0.3f );
 }
 
-void RendererGL::findLightsAndGetTexture(cv::Mat& texture, const cv::Mat& fisheye, int light_num_to_find)
+void RendererGL::printVertexMemory() const
+// The cow and the tiger are compared with their triangle soups in floats, which they were drawn from without indices.
 {
-   LongitudeLatitudeMapper->convertFisheye( texture, fisheye );
-   
-   std::vector<cv::Point> light_points;
-   LightFinder->estimateLightPositions( light_points, texture, light_num_to_find );
+   const auto float_vertex_size = static_cast<GLsizeiptr>(6 * sizeof( GLfloat ));
+   const auto tiger_vertex_num =
+      static_cast<GLsizeiptr>(MovingTigerObject->getKeyframeNum()) * MovingTigerObject->getVertexNum();
+   const GLsizeiptr float_size = (CowObject->getIndexNum() + tiger_vertex_num) * float_vertex_size;
+   const GLsizeiptr size = CowObject->getBufferSize() + MovingTigerObject->getBufferSize();
+   std::cout << ">> Vertex Memory: " << size << " bytes for the cow and the tiger with the indices, " << std::fixed
+      << std::setprecision( 1 ) << (float_size > 0 ? 100.0 * static_cast<double>(size) / float_size : 0.0)
+      << "% of " << float_size << " bytes in floats\n\n";
+   std::cout.unsetf( std::ios::floatfield );
+}
+
+void RendererGL::setReflectionCubemap(const cv::Mat& texture)
+// The longitude-latitude texture covers PI radian vertically, so a face of PI/2 radian gets a half of its rows.
+{
+   std::cout << ">> Bake Reflection Cube Map...\n";
+   const auto start = std::chrono::steady_clock::now();
+   cv::Mat cubemap;
+   LongitudeLatitudeMapper->convertToCubemap( cubemap, texture, std::max( texture.rows / 2, 1 ), 0 );
+   const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+   std::cout << ">> Baking Done. (" << cubemap.cols << "x" << cubemap.cols << " faces in " << elapsed << " ms)\n\n";
+
+   std::cout << ">> Prefilter Reflection Cube Map...\n";
+   const auto prefilter_start = std::chrono::steady_clock::now();
+   std::vector<cv::Mat> specular;
+   cv::Mat irradiance;
+   EnvironmentPrefilter prefilter;
+   const bool is_cached = prefilter.prefilter( specular, irradiance, cubemap, 0 );
+   const double prefilter_elapsed =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - prefilter_start).count();
+   std::cout << ">> Prefiltering Done. (" << specular.size() << " roughness levels and "
+      << irradiance.cols << "x" << irradiance.cols << " irradiance faces in " << prefilter_elapsed << " ms"
+      << (is_cached ? " from the cache" : "") << ")\n\n";
+
+   ReflectionCubemap = specular.empty() ? nullptr : TextureCache->getCubemapTexture( specular );
+   IrradianceCubemap = irradiance.empty() ? nullptr : TextureCache->getCubemapTexture( irradiance );
+   if (ReflectionCubemap == nullptr || IrradianceCubemap == nullptr) ReflectionMode = REFLECTION_MODE::ANALYTIC;
+}
+
+void RendererGL::setIrradianceCoefficients(const cv::Mat& texture)
+{
+   std::cout << ">> Project Environment onto Spherical Harmonics...\n";
+   const auto start = std::chrono::steady_clock::now();
+   SphericalHarmonics::Coefficients radiance;
+   SphericalHarmonics::project( radiance, texture, 0 );
+   SphericalHarmonics::convolveWithCosineLobe( IrradianceCoefficients, radiance );
+   const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+   std::cout << ">> Projecting Done. (" << SphericalHarmonics::CoefficientNum << " coefficients in " << elapsed
+      << " ms)\n\n";
+}
+
+void RendererGL::findLightsAndGetTexture(
+   cv::Mat& texture,
+   TextureCacheGL::Handle& environment_texture,
+   std::vector<LightPosition::LightInfo>& lights,
+   const cv::Mat& fisheye,
+   int light_num_to_find
+)
+// The texture drawn on the objects is converted by the compute shader, and the lights are found from it on the GPU, so
+// only the light list comes back. The fisheye image is converted on the CPU only if the compute shader cannot, and
+// LightPosition finds the lights only if the GPU cannot. The cube map bake and the spherical harmonics still run on the
+// CPU, so the converted pixels are read back from the texture for them, which is a copy instead of another remap.
+{
+   std::cout << ">> Convert Fisheye Image to Longitude-Latitude Texture on GPU...\n";
+   const auto start = std::chrono::steady_clock::now();
+   environment_texture = FisheyeConverter->convert( fisheye );
+   if (environment_texture != nullptr) FisheyeConverterGL::readTexture( texture, *environment_texture );
+   const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+   if (environment_texture != nullptr) std::cout << ">> Converting Done. (" << elapsed << " ms with the readback)\n\n";
+   else {
+      std::cout << ">> Convert Fisheye Image to Longitude-Latitude Image...\n";
+      LongitudeLatitudeMapper->convertFisheye( texture, fisheye, 0 );
+      std::cout << ">> Converting Done.\n\n";
+      environment_texture = TextureCache->getTexture( texture );
+   }
+
+   std::cout << ">> Find Light Positions on GPU...\n";
+   if (environment_texture != nullptr && LightEstimator->estimateLightPositions(
+         lights, *environment_texture, light_num_to_find, LightPosition::ALGORITHM::ADAPTIVE_MEDIAN_CUT
+      )) {
+      std::cout << ">> Finding Done. (" << LightEstimator->getReadbackBytes() << " bytes read back)\n\n";
+   }
+   else {
+      LightFinder->estimateLightPositions(
+         lights, texture, light_num_to_find, LightPosition::ALGORITHM::ADAPTIVE_MEDIAN_CUT
+      );
+   }
 
    const float color_scale = 1.0f / 255.0f;
    const float width_scale = static_cast<float>(CV_PI) / static_cast<float>(fisheye.cols - 1);
    const float height_scale = static_cast<float>(CV_PI) / static_cast<float>(fisheye.rows - 1);
    const glm::vec4 ambient_color(1.0f, 1.0f, 1.0f, 1.0f);
    const glm::vec4 specular_color(0.9f, 0.9f, 0.9f, 1.0f);
-   for (const auto& light : light_points) {
+   for (const auto& info : lights) {
+      const cv::Point& light = info.Position;
       const auto& color = fisheye.at<cv::Vec3b>(light.y, light.x);
       const glm::vec4 diffuse_color(
          static_cast<float>(color[2]) * color_scale, 
@@ -339,8 +481,16 @@ void RendererGL::findLightsAndGetTexture(cv::Mat& texture, const cv::Mat& fishey
    Lights->activateLight( 0 );
 }
 
+void RendererGL::showLightPositions(const cv::Mat& texture, const std::vector<LightPosition::LightInfo>& lights)
+{
+   cv::Mat light_positions = texture.clone();
+   LightPosition::drawLightPositions( light_positions, lights );
+   cv::imshow( "Light Positions", light_positions );
+}
+
 void RendererGL::drawEnvironment(float scale_factor) const
 {
+   const ProfilerGL::Scope scope(Profiler.get(), ProfilerGL::STAGE::DRAW_ENVIRONMENT);
    glUseProgram( EnvironmentShader->getShaderProgram() );
 
    const glm::mat4 to_world = scale( glm::mat4(1.0f), glm::vec3(scale_factor, scale_factor, scale_factor) );
@@ -352,11 +502,14 @@ void RendererGL::drawEnvironment(float scale_factor) const
    glDrawArrays( EnvironmentObject->getDrawMode(), 0, EnvironmentObject->getVertexNum() );
 }
 
-void RendererGL::drawMovingTiger(float scale_factor, float theta)
+void RendererGL::drawMovingTiger(float scale_factor, float theta, const glm::mat4& placement)
 {
+   if (MovingTigerObject->getKeyframeNum() == 0) return;
+
+   const ProfilerGL::Scope scope(Profiler.get(), ProfilerGL::STAGE::DRAW_MOVING_TIGER);
    glUseProgram( ObjectShader->getShaderProgram() );
 
-   const glm::mat4 to_world =
+   const glm::mat4 to_world = placement *
       rotate( glm::mat4(1.0f), glm::radians( theta ), glm::vec3(0.0f, 1.0f, 0.0f) ) * 
       translate( glm::mat4(1.0f), glm::vec3(EnvironmentRadius * 0.6f, 2.0f, 0.0f) ) *
       rotate( glm::mat4(1.0f), glm::radians( 180.0f ), glm::vec3(0.0f, 1.0f, 0.0f) ) * 
@@ -364,87 +517,603 @@ void RendererGL::drawMovingTiger(float scale_factor, float theta)
       scale( glm::mat4(1.0f), glm::vec3(scale_factor, scale_factor, scale_factor) );
    ObjectShader->transferBasicTransformationUniforms( to_world, MainCamera.get(), true );
    glUniform1f( ObjectShader->getLocation( "EnvironmentRadius" ), EnvironmentRadius );
-   const glm::vec3 activated_light_position = Lights->getLightPosition( ActivatedLightIndex );
-   glUniform3fv( ObjectShader->getLocation( "ActivatedLightPosition" ), 1, &activated_light_position[0] );
-   MovingTigerObjects[TigerIndex]->transferUniformsToShader( ObjectShader.get() );
-   Lights->transferUniformsToShader( ObjectShader.get() );
+   glUniform1i( ObjectShader->getLocation( "ReflectionMode" ), static_cast<int>(ReflectionMode) );
+   glUniform1i( ObjectShader->getLocation( "LightingMode" ), static_cast<int>(LightingMode) );
+   glUniform3fv(
+      ObjectShader->getLocation( "IrradianceCoefficients" ), SphericalHarmonics::CoefficientNum,
+      &IrradianceCoefficients[0][0]
+   );
+   glUniform1f( ObjectShader->getLocation( "KeyframeBlend" ), KeyframeBlend );
+   MovingTigerObject->transferUniformsToShader( ObjectShader.get() );
+   Lights->bindLightBuffer( MainCamera->getViewMatrix() );
 
-   glBindTextureUnit( 0, MovingTigerObjects[TigerIndex]->getTextureID( 0 ) );
-   glBindVertexArray( MovingTigerObjects[TigerIndex]->getVAO() );
-   glDrawArrays( MovingTigerObjects[TigerIndex]->getDrawMode(), 0, MovingTigerObjects[TigerIndex]->getVertexNum() );
+   const int next_tiger_index = (TigerIndex + 1) % MovingTigerObject->getKeyframeNum();
+   MovingTigerObject->setKeyframes( TigerIndex, next_tiger_index );
+   glBindTextureUnit( 0, MovingTigerObject->getTextureID( 0 ) );
+   if (ReflectionCubemap != nullptr) glBindTextureUnit( 1, *ReflectionCubemap );
+   if (IrradianceCubemap != nullptr) glBindTextureUnit( 2, *IrradianceCubemap );
+   glBindVertexArray( MovingTigerObject->getVAO() );
+   glDrawArrays( MovingTigerObject->getDrawMode(), 0, MovingTigerObject->getVertexNum() );
 }
 
-void RendererGL::drawCow(float scale_factor)
+void RendererGL::drawCow(float scale_factor, const glm::mat4& placement)
 {
+   const ProfilerGL::Scope scope(Profiler.get(), ProfilerGL::STAGE::DRAW_COW);
    glUseProgram( ObjectShader->getShaderProgram() );
 
-   const glm::mat4 to_world = 
+   const glm::mat4 to_world = placement *
       translate( glm::mat4(1.0f), glm::vec3(0.0f, 5.0f, 0.0f) ) *
       rotate( glm::mat4(1.0f), glm::radians( -90.0f ), glm::vec3(0.0f, 1.0f, 0.0f) ) * 
       scale( glm::mat4(1.0f), glm::vec3(scale_factor, scale_factor, scale_factor) );
    ObjectShader->transferBasicTransformationUniforms( to_world, MainCamera.get(), true );
    glUniform1f( ObjectShader->getLocation( "EnvironmentRadius" ), EnvironmentRadius );
-   const glm::vec3 activated_light_position = Lights->getLightPosition( ActivatedLightIndex );
-   glUniform3fv( ObjectShader->getLocation( "ActivatedLightPosition" ), 1, &activated_light_position[0] );
+   glUniform1i( ObjectShader->getLocation( "ReflectionMode" ), static_cast<int>(ReflectionMode) );
+   glUniform1i( ObjectShader->getLocation( "LightingMode" ), static_cast<int>(LightingMode) );
+   glUniform3fv(
+      ObjectShader->getLocation( "IrradianceCoefficients" ), SphericalHarmonics::CoefficientNum,
+      &IrradianceCoefficients[0][0]
+   );
+   glUniform1f( ObjectShader->getLocation( "KeyframeBlend" ), 0.0f );
    CowObject->transferUniformsToShader( ObjectShader.get() );
-   Lights->transferUniformsToShader( ObjectShader.get() );
+   Lights->bindLightBuffer( MainCamera->getViewMatrix() );
 
    glBindTextureUnit( 0, CowObject->getTextureID( 0 ) );
+   if (ReflectionCubemap != nullptr) glBindTextureUnit( 1, *ReflectionCubemap );
+   if (IrradianceCubemap != nullptr) glBindTextureUnit( 2, *IrradianceCubemap );
    glBindVertexArray( CowObject->getVAO() );
-   glDrawArrays( CowObject->getDrawMode(), 0, CowObject->getVertexNum() );
+   glDrawElements( CowObject->getDrawMode(), CowObject->getIndexNum(), GL_UNSIGNED_INT, nullptr );
 }
 
 void RendererGL::render()
 {
+   const ProfilerGL::Scope scope(Profiler.get(), ProfilerGL::STAGE::RENDER);
    glClear( OPENGL_COLOR_BUFFER_BIT | OPENGL_DEPTH_BUFFER_BIT );
 
    drawEnvironment( EnvironmentRadius );
-   if (DrawMovingObject) drawMovingTiger( 0.03f, static_cast<float>(TigerRotationAngle) );
+   if (DrawMovingObject) drawMovingTiger( 0.03f, static_cast<float>(TigerRotationAngle) + 3.0f * KeyframeBlend );
    else drawCow( 3.0f );
 
    glBindVertexArray( 0 );
    glUseProgram( 0 );
 }
 
+void RendererGL::renderInstances(const std::vector<glm::mat4>& placements)
+{
+   const ProfilerGL::Scope scope(Profiler.get(), ProfilerGL::STAGE::RENDER);
+   glClear( OPENGL_COLOR_BUFFER_BIT | OPENGL_DEPTH_BUFFER_BIT );
+
+   drawEnvironment( EnvironmentRadius );
+   for (size_t i = 0; i < placements.size(); ++i) {
+      if (i % 2 == 0) drawCow( 3.0f, placements[i] );
+      else drawMovingTiger( 0.03f, static_cast<float>(TigerRotationAngle), placements[i] );
+   }
+
+   glBindVertexArray( 0 );
+   glUseProgram( 0 );
+}
+
 void RendererGL::update()
 {
+   const ProfilerGL::Scope scope(Profiler.get(), ProfilerGL::STAGE::UPDATE);
    if (DrawMovingObject) {
       TigerIndex++;
-      if (TigerIndex == 12) TigerIndex = 0;
+      if (TigerIndex == MovingTigerObject->getKeyframeNum()) TigerIndex = 0;
       TigerRotationAngle += 3;
       if (TigerRotationAngle == 360) TigerRotationAngle = 0;
    }
 }
 
-void RendererGL::play(const cv::Mat& fisheye)
+void RendererGL::setScene(const cv::Mat& fisheye, bool shows_light_positions)
 {
-   if (glfwWindowShouldClose( Window )) initialize();
-
    cv::Mat texture;
-   findLightsAndGetTexture( texture, fisheye );
-   setEnvironmentObject( texture );
-   setMovingTigerObjects( texture );
-   setCowObject( texture );
-   EnvironmentShader->setUniformLocations( 0 );
-   ObjectShader->setUniformLocations( Lights->getTotalLightNum() );
+   TextureCacheGL::Handle environment_texture;
+   std::vector<LightPosition::LightInfo> lights;
+   findLightsAndGetTexture( texture, environment_texture, lights, fisheye );
+   if (shows_light_positions) showLightPositions( texture, lights );
+   setEnvironmentObject( environment_texture );
+   setMovingTigerObject( environment_texture );
+   setCowObject( environment_texture );
+   printVertexMemory();
+   setReflectionCubemap( texture );
+   setIrradianceCoefficients( texture );
+   EnvironmentShader->setUniformLocations();
+   ObjectShader->setUniformLocations();
    ObjectShader->addUniformLocation( "EnvironmentRadius" );
-   ObjectShader->addUniformLocation( "ActivatedLightPosition" );
+   ObjectShader->addUniformLocation( "KeyframeBlend" );
+   ObjectShader->addUniformLocation( "ReflectionMode" );
+   ObjectShader->addUniformLocation( "LightingMode" );
+   ObjectShader->addUniformLocation( "IrradianceCoefficients" );
+}
+
+void RendererGL::toggleProfiling()
+{
+   if (!Profiler->isEnabled()) {
+      Profiler->setEnabled( true );
+      std::cout << "Profiling Started!\n";
+      return;
+   }
+
+   Profiler->setEnabled( false );
+   Profiler->printReport();
+   if (writeProfile( ProfilePath )) std::cout << "Profile Written: " << ProfilePath << ".csv/.json\n\n";
+}
+
+bool RendererGL::writeProfile(const std::string& profile_path) const
+{
+   const std::filesystem::path directory_path = std::filesystem::path(profile_path).parent_path();
+   if (!directory_path.empty()) {
+      std::error_code error;
+      std::filesystem::create_directories( directory_path, error );
+      if (error) {
+         std::cerr << "Could not create profile directory " << directory_path.string() << "\n";
+         return false;
+      }
+   }
+   const bool csv_written = Profiler->writeCSV( profile_path + ".csv" );
+   const bool json_written = Profiler->writeJSON( profile_path + ".json" );
+   return csv_written && json_written;
+}
+
+CameraPath::SceneState RendererGL::getSceneState() const
+{
+   CameraPath::SceneState scene;
+   scene.DrawMovingObject = DrawMovingObject;
+   scene.ReflectionMode = static_cast<int>(ReflectionMode);
+   scene.LightingMode = static_cast<int>(LightingMode);
+   scene.LightOn = Lights->isLightOn();
+   scene.ActivatedLightIndex = ActivatedLightIndex;
+   scene.TigerIndex = TigerIndex;
+   scene.TigerRotationAngle = TigerRotationAngle;
+   return scene;
+}
+
+void RendererGL::setSceneState(const CameraPath::SceneState& scene)
+{
+   DrawMovingObject = scene.DrawMovingObject;
+   ReflectionMode = scene.ReflectionMode == static_cast<int>(REFLECTION_MODE::CUBEMAP) ?
+      REFLECTION_MODE::CUBEMAP : REFLECTION_MODE::ANALYTIC;
+   LightingMode = scene.LightingMode == static_cast<int>(LIGHTING_MODE::SPHERICAL_HARMONICS) ?
+      LIGHTING_MODE::SPHERICAL_HARMONICS : LIGHTING_MODE::POINT_LIGHTS;
+   if (Lights->isLightOn() != scene.LightOn) Lights->toggleLightSwitch();
+   if (Lights->getTotalLightNum() > 0) {
+      Lights->deactivateLight( ActivatedLightIndex );
+      ActivatedLightIndex = std::clamp( scene.ActivatedLightIndex, 0, Lights->getTotalLightNum() - 1 );
+      Lights->activateLight( ActivatedLightIndex );
+   }
+   TigerIndex = std::max( scene.TigerIndex, 0 ) % std::max( MovingTigerObject->getKeyframeNum(), 1 );
+   TigerRotationAngle = scene.TigerRotationAngle;
+}
+
+void RendererGL::toggleCameraPathRecording()
+{
+   if (RecordedPath == nullptr) {
+      RecordedPath = std::make_unique<CameraPath>();
+      RecordedPath->begin( getSceneState() );
+      RecordingStartTime = glfwGetTime();
+      std::cout << "Camera Path Recording Started!\n";
+      return;
+   }
+
+   const std::filesystem::path directory_path = std::filesystem::path(CMAKE_BINARY_DIR) / "camera_paths";
+   std::error_code error;
+   std::filesystem::create_directories( directory_path, error );
+   const std::string file_path = (directory_path / "camera_path.txt").string();
+   if (!error && RecordedPath->save( file_path )) {
+      std::cout << "Camera Path Recorded: " << file_path << " (" << RecordedPath->getDuration() << " sec)\n";
+   }
+   RecordedPath.reset();
+}
+
+void RendererGL::play(const cv::Mat& fisheye, const std::string& profile_path)
+{
+   if (OffscreenContext != nullptr) {
+      std::cerr << "An offscreen renderer cannot play interactively.\n";
+      return;
+   }
+   if (glfwWindowShouldClose( Window )) initialize();
+
+   setScene( fisheye, true );
+
+   ProfilePath = profile_path.empty() ? std::string(CMAKE_BINARY_DIR) + "/profiles/profile" : profile_path;
+   if (!profile_path.empty()) toggleProfiling();
 
-   const double update_time = 0.1;
    double last = glfwGetTime(), time_delta = 0.0;
    while (!glfwWindowShouldClose( Window )) {
+      Profiler->beginFrame();
       const double now = glfwGetTime();
       time_delta += now - last;
       last = now;
-      if (time_delta >= update_time) {
+      if (time_delta >= UpdateInterval) {
          update();
-         time_delta -= update_time;
+         time_delta -= UpdateInterval;
       }
+      // The tiger is blended between the keyframes by the time passed since the last update.
+      KeyframeBlend = static_cast<float>(std::min( time_delta / UpdateInterval, 1.0 ));
 
+      if (RecordedPath != nullptr) RecordedPath->addCameraState( now - RecordingStartTime, *MainCamera );
       render();
 
       glfwSwapBuffers( Window );
       glfwPollEvents();
+      Profiler->endFrame();
+   }
+   if (Profiler->isEnabled()) toggleProfiling();
+   if (RecordedPath != nullptr) toggleCameraPathRecording();
+   glfwDestroyWindow( Window );
+}
+
+bool RendererGL::replayCameraPath(
+   const cv::Mat& fisheye,
+   const std::string& camera_path_file,
+   const std::string& profile_path,
+   double step
+)
+// The scene is updated by the simulated time, not by the clock, so every run draws the same frames. The offscreen
+// renderer waits for each frame to finish instead of swapping the buffers, and shows no window, so it runs without a
+// display.
+{
+   CameraPath path;
+   if (step <= 0.0 || !path.load( camera_path_file )) return false;
+
+   if (OffscreenContext == nullptr) {
+      if (glfwWindowShouldClose( Window )) initialize();
+   }
+   else if (FBO == 0) {
+      std::cerr << "The renderer has no offscreen framebuffer.\n";
+      return false;
+   }
+
+   setScene( fisheye, OffscreenContext == nullptr );
+   if (OffscreenContext == nullptr) glfwSwapInterval( 0 );
+   setSceneState( path.getSceneState() );
+
+   const auto& key_events = path.getKeyEvents();
+   const auto frame_num = static_cast<int>(std::floor( path.getDuration() / step )) + 1;
+   size_t key_index = 0;
+   double time_delta = 0.0;
+   int replayed_num = 0;
+   Profiler->setEnabled( true );
+   for (; replayed_num < frame_num; ++replayed_num) {
+      if (OffscreenContext == nullptr && glfwWindowShouldClose( Window )) break;
+
+      Profiler->beginFrame();
+      const double time = replayed_num * step;
+      for (; key_index < key_events.size() && key_events[key_index].Time <= time; ++key_index) {
+         keyboard( Window, key_events[key_index].Key, 0, GLFW_PRESS, 0 );
+      }
+      if (replayed_num > 0) {
+         time_delta += step;
+         for (; time_delta >= UpdateInterval; time_delta -= UpdateInterval) update();
+      }
+      KeyframeBlend = static_cast<float>(std::min( time_delta / UpdateInterval, 1.0 ));
+
+      const CameraPath::CameraState state = path.getCameraState( time );
+      MainCamera->setState( state.Position, state.Orientation, state.FOV );
+      render();
+
+      if (OffscreenContext == nullptr) {
+         glfwSwapBuffers( Window );
+         glfwPollEvents();
+      }
+      else glFinish();
+      Profiler->endFrame();
+   }
+   Profiler->setEnabled( false );
+
+   std::cout << "****************************************************************\n";
+   std::cout << " - Replay: " << replayed_num << " of " << frame_num << " frames of " << camera_path_file << "\n";
+   std::cout << " - Path  : " << std::fixed << std::setprecision( 3 ) << path.getDuration() << " sec at the step of "
+      << step * 1e+3 << " ms, " << key_events.size() << " keys, " << FrameWidth << "x" << FrameHeight
+      << (OffscreenContext == nullptr ? ", vsync off\n" : ", offscreen\n");
+   std::cout.unsetf( std::ios::floatfield );
+   Profiler->printReport();
+   const bool written = writeProfile( profile_path );
+   if (written) std::cout << "Profile Written: " << profile_path << ".csv/.json\n\n";
+   if (OffscreenContext == nullptr) glfwDestroyWindow( Window );
+   return written && replayed_num == frame_num;
+}
+
+void RendererGL::benchmarkReflection(const cv::Mat& fisheye, int frame_num)
+{
+   if (glfwWindowShouldClose( Window )) initialize();
+
+   setScene( fisheye, true );
+   glfwSwapInterval( 0 );
+
+   GLuint query;
+   glCreateQueries( GL_TIME_ELAPSED, 1, &query );
+   std::cout << "****************************************************************\n";
+   for (const auto mode : { REFLECTION_MODE::ANALYTIC, REFLECTION_MODE::CUBEMAP }) {
+      if (mode == REFLECTION_MODE::CUBEMAP && ReflectionCubemap == nullptr) continue;
+
+      ReflectionMode = mode;
+      render();
+      glFinish();
+
+      const auto start = std::chrono::steady_clock::now();
+      glBeginQuery( GL_TIME_ELAPSED, query );
+      for (int i = 0; i < frame_num; ++i) render();
+      glEndQuery( GL_TIME_ELAPSED );
+      glFinish();
+      const double cpu_elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+      GLuint64 gpu_elapsed = 0;
+      glGetQueryObjectui64v( query, GL_QUERY_RESULT, &gpu_elapsed );
+      std::cout << " - Reflection " << std::setw( 8 ) << std::left
+         << (mode == REFLECTION_MODE::CUBEMAP ? "Cube Map" : "Analytic") << std::right << ": "
+         << std::fixed << std::setprecision( 3 ) << static_cast<double>(gpu_elapsed) * 1e-6 / frame_num
+         << " ms on GPU, " << cpu_elapsed / frame_num << " ms in total per frame (" << frame_num << " frames)\n";
+      std::cout.unsetf( std::ios::floatfield );
+      glfwPollEvents();
    }
+   std::cout << "****************************************************************\n\n";
+   glDeleteQueries( 1, &query );
    glfwDestroyWindow( Window );
+}
+
+bool RendererGL::benchmarkScenes(
+   const cv::Mat& fisheye,
+   const std::vector<int>& instance_nums,
+   const std::vector<int>& light_nums,
+   const std::vector<cv::Size>& frame_sizes,
+   int frame_num,
+   const std::string& csv_path
+)
+// The instances are placed on a golden-angle spiral over the floor, and scaled down as they get more, so that they stay
+// in the view. The scene and the most lights are set once, and each configuration switches on only the first lights.
+// The heights of the lights follow the golden ratio, so that any first lights are spread over the dome. Each frame is
+// finished before the next one, so the frame time is the whole latency of a frame, and its GPU time is read without a
+// stall.
+{
+   if (OffscreenContext == nullptr || FBO == 0) {
+      std::cerr << "The renderer has no offscreen framebuffer.\n";
+      return false;
+   }
+
+   const std::filesystem::path directory_path = std::filesystem::path(csv_path).parent_path();
+   std::error_code error;
+   if (!directory_path.empty()) std::filesystem::create_directories( directory_path, error );
+   std::ofstream csv(csv_path);
+   if (error || !csv.is_open()) {
+      std::cerr << "Could not write benchmark " << csv_path << "\n";
+      return false;
+   }
+   csv << "instances,lights,width,height,draw_calls,triangles,frame_mean_ms,frame_p50_ms,frame_p95_ms,frame_p99_ms,"
+      "gpu_mean_ms,gpu_p50_ms,gpu_p95_ms,gpu_p99_ms,triangles_per_sec\n";
+
+   setScene( fisheye, false );
+   MainCamera->setPose( glm::vec3(0.0f, 8.0f, -6.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) );
+   LightingMode = LIGHTING_MODE::POINT_LIGHTS;
+   std::unique_ptr<LightGL> found_lights = std::move( Lights );
+
+   const float golden_angle = glm::pi<float>() * (3.0f - std::sqrt( 5.0f ));
+   const float golden_ratio_conjugate = (std::sqrt( 5.0f ) - 1.0f) * 0.5f;
+   const int max_light_num =
+      light_nums.empty() ? 0 : std::max( *std::max_element( light_nums.begin(), light_nums.end() ), 0 );
+   const float light_intensity = 1.0f / std::sqrt( static_cast<float>(std::max( max_light_num, 1 )) );
+   Lights = std::make_unique<LightGL>();
+   for (int i = 0; i < max_light_num; ++i) {
+      const float height = 1.0f - std::fmod( (static_cast<float>(i) + 0.5f) * golden_ratio_conjugate, 1.0f );
+      const float radius = std::sqrt( 1.0f - height * height );
+      const float angle = golden_angle * static_cast<float>(i);
+      Lights->addLight(
+         glm::vec4(8.0f * radius * std::cos( angle ), 8.0f * height, 8.0f * radius * std::sin( angle ), 1.0f),
+         glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+         glm::vec4(glm::vec3(light_intensity), 1.0f),
+         glm::vec4(glm::vec3(light_intensity), 1.0f)
+      );
+   }
+   const GLsizei environment_triangles = EnvironmentObject->getVertexNum() / 3;
+   const GLsizei cow_triangles = CowObject->getIndexNum() / 3;
+   const GLsizei tiger_triangles = MovingTigerObject->getKeyframeNum() > 0 ? MovingTigerObject->getVertexNum() / 3 : 0;
+   bool succeeded = true;
+   GLuint query;
+   glCreateQueries( GL_TIME_ELAPSED, 1, &query );
+   std::cout << "****************************************************************\n";
+   for (const auto& frame_size : frame_sizes) {
+      FrameWidth = std::max( frame_size.width, 1 );
+      FrameHeight = std::max( frame_size.height, 1 );
+      if (!setOffscreenFramebuffer()) {
+         succeeded = false;
+         break;
+      }
+      MainCamera->updateWindowSize( FrameWidth, FrameHeight );
+
+      for (const auto& light_num : light_nums) {
+         for (int i = 0; i < max_light_num; ++i) {
+            if (i < light_num) Lights->activateLight( i );
+            else Lights->deactivateLight( i );
+         }
+
+         for (const auto& instance_num : instance_nums) {
+            std::vector<glm::mat4> placements;
+            const auto spread = static_cast<float>(std::max( instance_num, 1 ));
+            const float scale_factor = std::min( 1.0f, 1.5f / std::sqrt( spread ) );
+            for (int i = 0; i < instance_num; ++i) {
+               const float radius =
+                  instance_num > 1 ? 6.0f * std::sqrt( (static_cast<float>(i) + 0.5f) / spread ) : 0.0f;
+               const float angle = golden_angle * static_cast<float>(i);
+               const glm::vec3 position(radius * std::cos( angle ), 0.0f, radius * std::sin( angle ));
+               placements.emplace_back(
+                  translate( glm::mat4(1.0f), position ) *
+                  rotate( glm::mat4(1.0f), -angle, glm::vec3(0.0f, 1.0f, 0.0f) ) *
+                  scale( glm::mat4(1.0f), glm::vec3(scale_factor) )
+               );
+            }
+            const int cow_num = (instance_num + 1) / 2;
+            const int tiger_num = tiger_triangles > 0 ? instance_num / 2 : 0;
+            const int draw_call_num = 1 + cow_num + tiger_num;
+            const double triangle_num = static_cast<double>(environment_triangles) +
+               static_cast<double>(cow_num) * cow_triangles + static_cast<double>(tiger_num) * tiger_triangles;
+
+            renderInstances( placements );
+            glFinish();
+
+            std::vector<double> frame_times, gpu_times;
+            const auto start = std::chrono::steady_clock::now();
+            for (int f = 0; f < frame_num; ++f) {
+               const auto frame_start = std::chrono::steady_clock::now();
+               glBeginQuery( GL_TIME_ELAPSED, query );
+               renderInstances( placements );
+               glEndQuery( GL_TIME_ELAPSED );
+               glFinish();
+               frame_times.emplace_back(
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count()
+               );
+               GLuint64 gpu_elapsed = 0;
+               glGetQueryObjectui64v( query, GL_QUERY_RESULT, &gpu_elapsed );
+               gpu_times.emplace_back( static_cast<double>(gpu_elapsed) * 1e-6 );
+            }
+            const double total_seconds =
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::sort( frame_times.begin(), frame_times.end() );
+            std::sort( gpu_times.begin(), gpu_times.end() );
+            const double frame_mean =
+               std::accumulate( frame_times.begin(), frame_times.end(), 0.0 ) / static_cast<double>(frame_num);
+            const double gpu_mean =
+               std::accumulate( gpu_times.begin(), gpu_times.end(), 0.0 ) / static_cast<double>(frame_num);
+            const double triangles_per_second = total_seconds > 0.0 ? triangle_num * frame_num / total_seconds : 0.0;
+
+            std::cout << " - Scene: " << instance_num << " instances, " << light_num << " lights, " << FrameWidth << "x"
+               << FrameHeight << " (" << draw_call_num << " draw calls, " << static_cast<long long>(triangle_num)
+               << " triangles per frame)\n";
+            std::cout << std::fixed << std::setprecision( 3 ) << "      frame mean " << frame_mean << " ms, p50 "
+               << ProfilerGL::getPercentile( frame_times, 50.0 ) << ", p95 "
+               << ProfilerGL::getPercentile( frame_times, 95.0 ) << ", p99 "
+               << ProfilerGL::getPercentile( frame_times, 99.0 ) << " / GPU mean " << gpu_mean << " ms / "
+               << std::setprecision( 2 ) << triangles_per_second * 1e-6 << " M triangles per sec\n";
+            std::cout.unsetf( std::ios::floatfield );
+
+            csv << instance_num << "," << light_num << "," << FrameWidth << "," << FrameHeight << "," << draw_call_num
+               << "," << static_cast<long long>(triangle_num) << std::fixed << std::setprecision( 6 ) << ","
+               << frame_mean << "," << ProfilerGL::getPercentile( frame_times, 50.0 ) << ","
+               << ProfilerGL::getPercentile( frame_times, 95.0 ) << ","
+               << ProfilerGL::getPercentile( frame_times, 99.0 ) << "," << gpu_mean << ","
+               << ProfilerGL::getPercentile( gpu_times, 50.0 ) << "," << ProfilerGL::getPercentile( gpu_times, 95.0 )
+               << "," << ProfilerGL::getPercentile( gpu_times, 99.0 ) << "," << std::setprecision( 1 )
+               << triangles_per_second << "\n";
+            csv.unsetf( std::ios::floatfield );
+         }
+      }
+   }
+   std::cout << "****************************************************************\n\n";
+   glDeleteQueries( 1, &query );
+   Lights = std::move( found_lights );
+   std::cout << "Benchmark Written: " << csv_path << "\n\n";
+   return succeeded && static_cast<bool>(csv);
+}
+
+bool RendererGL::renderOffscreen(
+   const cv::Mat& fisheye,
+   const std::string& script_path,
+   const std::string& output_directory_path
+)
+// Each frame is read into a pixel buffer object asynchronously, and mapped after the next frame is issued, so the GPU
+// does not wait for the copy. The images are encoded on another thread, which is connected by a bounded queue.
+{
+   if (OffscreenContext == nullptr || FBO == 0) {
+      std::cerr << "The renderer has no offscreen framebuffer.\n";
+      return false;
+   }
+
+   std::vector<RenderScript::Frame> frames;
+   if (!RenderScript::load( frames, script_path )) return false;
+
+   std::error_code error;
+   std::filesystem::create_directories( output_directory_path, error );
+   if (error) {
+      std::cerr << "Could not create output directory " << output_directory_path << "\n";
+      return false;
+   }
+
+   setScene( fisheye, false );
+
+   const auto frame_size = static_cast<GLsizeiptr>(FrameWidth) * FrameHeight * 3;
+   std::array<GLuint, 2> pixel_buffers{};
+   glCreateBuffers( static_cast<GLsizei>(pixel_buffers.size()), pixel_buffers.data() );
+   for (const auto& buffer : pixel_buffers) glNamedBufferStorage( buffer, frame_size, nullptr, GL_MAP_READ_BIT );
+   glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+
+   BoundedQueue<std::pair<int, cv::Mat>> images(4);
+   int written_num = 0;
+   double write_seconds = 0.0;
+   std::thread writer([&]() {
+      std::pair<int, cv::Mat> image;
+      while (images.pop( image )) {
+         const auto begin = std::chrono::steady_clock::now();
+         std::ostringstream image_path;
+         image_path << output_directory_path << "/frame_" << std::setw( 5 ) << std::setfill( '0' ) << image.first << ".png";
+         if (!cv::imwrite( image_path.str(), image.second, { cv::IMWRITE_PNG_COMPRESSION, 1 } )) {
+            std::cerr << "Could not write image " << image_path.str() << "\n";
+            break;
+         }
+         write_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+         written_num++;
+      }
+      images.close();
+   });
+
+   double push_seconds = 0.0;
+   const auto push_image = [&](int index) {
+      const GLuint buffer = pixel_buffers[index % pixel_buffers.size()];
+      const auto* pixels = static_cast<uchar*>(glMapNamedBufferRange( buffer, 0, frame_size, GL_MAP_READ_BIT ));
+      if (pixels == nullptr) {
+         std::cerr << "Could not map the pixel buffer of frame " << index << "\n";
+         return false;
+      }
+
+      cv::Mat image;
+      cv::flip( cv::Mat(FrameHeight, FrameWidth, CV_8UC3, const_cast<uchar*>(pixels)), image, 0 );
+      glUnmapNamedBuffer( buffer );
+
+      const auto begin = std::chrono::steady_clock::now();
+      const bool pushed = images.push( { index, std::move( image ) } );
+      push_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+      return pushed;
+   };
+
+   Profiler->setEnabled( true );
+   const auto start = std::chrono::steady_clock::now();
+   int rendered_num = 0;
+   for (const auto& frame : frames) {
+      Profiler->beginFrame();
+      MainCamera->setPose( frame.CameraPosition, frame.CameraTarget, glm::vec3(0.0f, 1.0f, 0.0f) );
+      DrawMovingObject = frame.DrawMovingObject;
+      TigerIndex = frame.TigerIndex % std::max( MovingTigerObject->getKeyframeNum(), 1 );
+      KeyframeBlend = frame.KeyframeBlend;
+      TigerRotationAngle = frame.TigerRotationAngle;
+      render();
+
+      glBindBuffer( GL_PIXEL_PACK_BUFFER, pixel_buffers[rendered_num % pixel_buffers.size()] );
+      glReadPixels( 0, 0, FrameWidth, FrameHeight, GL_BGR, GL_UNSIGNED_BYTE, nullptr );
+      glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+      if (rendered_num > 0 && !push_image( rendered_num - 1 )) break;
+      rendered_num++;
+      Profiler->endFrame();
+   }
+   if (rendered_num == static_cast<int>(frames.size())) push_image( rendered_num - 1 );
+   const double render_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - push_seconds;
+   images.close();
+   writer.join();
+   const double total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   glDeleteBuffers( static_cast<GLsizei>(pixel_buffers.size()), pixel_buffers.data() );
+
+   std::cout << "****************************************************************\n";
+   std::cout << " - Offscreen Frames: " << written_num << " of " << frames.size() << " at " << FrameWidth << "x"
+      << FrameHeight << " in " << std::fixed << std::setprecision( 3 ) << total_seconds << " sec ("
+      << std::setprecision( 2 ) << (total_seconds > 0.0 ? written_num / total_seconds : 0.0) << " fps)\n";
+   std::cout << " - Stage render : " << rendered_num << " frames, busy " << std::setprecision( 3 ) << render_seconds
+      << " sec (" << std::setprecision( 2 ) << (render_seconds > 0.0 ? rendered_num / render_seconds : 0.0)
+      << " fps alone)\n";
+   std::cout << " - Stage write  : " << written_num << " frames, busy " << std::setprecision( 3 ) << write_seconds
+      << " sec (" << std::setprecision( 2 ) << (write_seconds > 0.0 ? written_num / write_seconds : 0.0)
+      << " fps alone)\n";
+   std::cout << "****************************************************************\n\n";
+   std::cout.unsetf( std::ios::floatfield );
+
+   Profiler->setEnabled( false );
+   Profiler->printReport();
+   return writeProfile( output_directory_path + "/profile" ) && written_num == static_cast<int>(frames.size());
 }
\ No newline at end of file
@@ -1,12 +1,14 @@
 #include "Shader.h"
 
-ShaderGL::ShaderGL() : ShaderProgram( 0 )
+ShaderGL::ShaderGL() : ShaderProgram( 0 ), TransformBuffer( 0 )
 {
 }
 
 ShaderGL::~ShaderGL()
 {
    if (ShaderProgram != 0) glDeleteProgram( ShaderProgram );
+   if (TransformBuffer != 0) glDeleteBuffers( 1, &TransformBuffer );
+   for (const auto& program : ComputeShaderPrograms) glDeleteProgram( program );
 }
 
 void ShaderGL::readShaderFile(std::string& shader_contents, const char* shader_path)
@@ -31,6 +33,7 @@ std::string ShaderGL::getShaderTypeString(GLenum shader_type)
       case GL_VERTEX_SHADER: return "Vertex Shader";
       case GL_FRAGMENT_SHADER: return "Fragment Shader";
       case GL_GEOMETRY_SHADER: return "Geometry Shader";
+      case GL_COMPUTE_SHADER: return "Compute Shader";
       default: return "";
    }
 }
@@ -97,10 +100,16 @@ void ShaderGL::setShader(
    if (geometry_shader != 0) glDeleteShader( geometry_shader );
    if (tessellation_control_shader != 0) glDeleteShader( tessellation_control_shader );
    if (tessellation_evaluation_shader != 0) glDeleteShader( tessellation_evaluation_shader );
+
+   if (TransformBuffer == 0) {
+      glCreateBuffers( 1, &TransformBuffer );
+      glNamedBufferStorage( TransformBuffer, sizeof( TransformBlock ), nullptr, GL_DYNAMIC_STORAGE_BIT );
+   }
 }
 
 void ShaderGL::setComputeShaders(const std::vector<const char*>& compute_shader_paths)
 {
+   for (const auto& program : ComputeShaderPrograms) glDeleteProgram( program );
    ComputeShaderPrograms.clear();
    ComputeShaderPrograms.resize( compute_shader_paths.size() );
    for (size_t i = 0; i < ComputeShaderPrograms.size(); ++i) {
@@ -112,43 +121,21 @@ void ShaderGL::setComputeShaders(const std::vector<const char*>& compute_shader_
    }
 }
 
-void ShaderGL::setBasicTransformationUniforms()
+void ShaderGL::setUniformLocations()
 {
-   Location.World = glGetUniformLocation( ShaderProgram, "WorldMatrix" );
-   Location.View = glGetUniformLocation( ShaderProgram, "ViewMatrix" );
-   Location.Projection = glGetUniformLocation( ShaderProgram, "ProjectionMatrix" );
-   Location.ModelViewProjection = glGetUniformLocation( ShaderProgram, "ModelViewProjectionMatrix" );
-}
-
-void ShaderGL::setUniformLocations(int light_num)
-{
-   setBasicTransformationUniforms();
+   Location.PositionScale = glGetUniformLocation( ShaderProgram, "PositionScale" );
+   Location.PositionOffset = glGetUniformLocation( ShaderProgram, "PositionOffset" );
+   Location.UseOctahedralNormal = glGetUniformLocation( ShaderProgram, "UseOctahedralNormal" );
 
    Location.MaterialEmission = glGetUniformLocation( ShaderProgram, "Material.EmissionColor" );
    Location.MaterialAmbient = glGetUniformLocation( ShaderProgram, "Material.AmbientColor" );
    Location.MaterialDiffuse = glGetUniformLocation( ShaderProgram, "Material.DiffuseColor" );
    Location.MaterialSpecular = glGetUniformLocation( ShaderProgram, "Material.SpecularColor" );
    Location.MaterialSpecularExponent = glGetUniformLocation( ShaderProgram, "Material.SpecularExponent" );
+   Location.MaterialRoughness = glGetUniformLocation( ShaderProgram, "Material.Roughness" );
 
    Location.Texture[0] = glGetUniformLocation( ShaderProgram, "BaseTexture" );
    Location.UseTexture = glGetUniformLocation( ShaderProgram, "UseTexture" );
-
-   Location.UseLight = glGetUniformLocation( ShaderProgram, "UseLight" );
-   Location.LightNum = glGetUniformLocation( ShaderProgram, "LightNum" );
-   Location.GlobalAmbient = glGetUniformLocation( ShaderProgram, "GlobalAmbient" );
-
-   Location.Lights.resize( light_num );
-   for (int i = 0; i < light_num; ++i) {
-      Location.Lights[i].LightSwitch = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].LightSwitch").c_str() );
-      Location.Lights[i].LightPosition = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].Position").c_str() );
-      Location.Lights[i].LightAmbient = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].AmbientColor").c_str() );
-      Location.Lights[i].LightDiffuse = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].DiffuseColor").c_str() );
-      Location.Lights[i].LightSpecular = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpecularColor").c_str() );
-      Location.Lights[i].SpotlightDirection = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpotlightDirection").c_str() );
-      Location.Lights[i].SpotlightCutoffAngle = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpotlightCutoffAngle").c_str() );
-      Location.Lights[i].SpotlightFeather = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpotlightFeather").c_str() );
-      Location.Lights[i].LightFallOffRadius = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].FallOffRadius").c_str() );
-   }
 }
 
 void ShaderGL::addUniformLocation(const std::string& name)
@@ -163,13 +150,17 @@ void ShaderGL::addUniformLocationToComputeShader(const std::string& name, int sh
 
 void ShaderGL::transferBasicTransformationUniforms(const glm::mat4& to_world, const CameraGL* camera, bool use_texture) const
 {
-   const glm::mat4 view = camera->getViewMatrix();
-   const glm::mat4 projection = camera->getProjectionMatrix();
-   const glm::mat4 model_view_projection = projection * view * to_world;
-   glUniformMatrix4fv( Location.World, 1, GL_FALSE, &to_world[0][0] );
-   glUniformMatrix4fv( Location.View, 1, GL_FALSE, &view[0][0] );
-   glUniformMatrix4fv( Location.Projection, 1, GL_FALSE, &projection[0][0] );
-   glUniformMatrix4fv( Location.ModelViewProjection, 1, GL_FALSE, &model_view_projection[0][0] );
+   TransformBlock transform;
+   transform.WorldMatrix = to_world;
+   transform.ViewMatrix = camera->getViewMatrix();
+   transform.ProjectionMatrix = camera->getProjectionMatrix();
+   transform.ModelViewProjectionMatrix = transform.ProjectionMatrix * transform.ViewMatrix * to_world;
+   transform.WorldNormalMatrix = glm::transpose( glm::inverse( to_world ) );
+   const glm::mat4 inverse_view = glm::inverse( transform.ViewMatrix );
+   transform.ViewNormalMatrix = glm::transpose( inverse_view );
+   transform.EyePosition = inverse_view[3];
+   glNamedBufferSubData( TransformBuffer, 0, sizeof( TransformBlock ), &transform );
+   glBindBufferBase( GL_UNIFORM_BUFFER, TransformBlockBinding, TransformBuffer );
 
    for (const auto& texture : Location.Texture) {
       glUniform1i( texture.second, texture.first );
@@ -0,0 +1,108 @@
+#include "SphericalHarmonics.h"
+
+void SphericalHarmonics::getRowMoments(
+   std::vector<RowMoments>& row_moments,
+   const cv::Mat& longitude_latitude,
+   const cv::Mat& azimuthal_bases,
+   const cv::Range& row_range
+)
+// The radiance is split into the planes of each channel, so every moment is a dot product of contiguous floats, which
+// OpenCV runs in SIMD.
+{
+   cv::Mat row_in_floats;
+   std::array<cv::Mat, 3> planes;
+   for (int j = row_range.start; j < row_range.end; ++j) {
+      longitude_latitude.row( j ).convertTo( row_in_floats, CV_32FC3 );
+      cv::split( row_in_floats, planes.data() );
+
+      RowMoments& moments = row_moments[j];
+      for (int m = 0; m < MOMENT_NUM; ++m) {
+         const cv::Mat basis = azimuthal_bases.row( m );
+         moments[m] = glm::dvec3(planes[2].dot( basis ), planes[1].dot( basis ), planes[0].dot( basis ));
+      }
+   }
+}
+
+void SphericalHarmonics::project(Coefficients& radiance, const cv::Mat& longitude_latitude, int thread_num)
+/*
+   The pixel (i, j) of W x H looks at the direction below, as LongitudeLatitudeMapping::getReflectedTextureCoordinates().
+    -> phi = PI * (i + 0.5) / W, theta = PI * (j + 0.5) / H
+    -> (x, y, z) = (-sin(theta) * cos(phi), sin(theta) * sin(phi), -cos(theta))
+   The basis is separable into the terms of theta and of phi, so each row needs only 5 moments of phi per channel.
+*/
+{
+   radiance.fill( glm::vec3(0.0f) );
+   if (longitude_latitude.empty() || longitude_latitude.type() != CV_8UC3) {
+      std::cerr << "Only a BGR image can be projected onto the spherical harmonics.\n";
+      return;
+   }
+
+   const int width = longitude_latitude.cols;
+   const int height = longitude_latitude.rows;
+   cv::Mat azimuthal_bases(MOMENT_NUM, width, CV_32FC1);
+   for (int i = 0; i < width; ++i) {
+      const double phi = CV_PI * (i + 0.5) / width;
+      azimuthal_bases.at<float>( CONSTANT, i ) = 1.0f;
+      azimuthal_bases.at<float>( COS_PHI, i ) = static_cast<float>(cos( phi ));
+      azimuthal_bases.at<float>( SIN_PHI, i ) = static_cast<float>(sin( phi ));
+      azimuthal_bases.at<float>( COS_2PHI, i ) = static_cast<float>(cos( 2.0 * phi ));
+      azimuthal_bases.at<float>( SIN_2PHI, i ) = static_cast<float>(sin( 2.0 * phi ));
+   }
+
+   std::vector<RowMoments> row_moments(height);
+   runRowsInParallel(
+      height, thread_num,
+      [&](int start, int end) { getRowMoments( row_moments, longitude_latitude, azimuthal_bases, { start, end } ); }
+   );
+
+   std::array<glm::dvec3, CoefficientNum> sums{};
+   const double pixel_solid_angle = CV_PI * CV_PI / (static_cast<double>(width) * height) / 255.0;
+   for (int j = 0; j < height; ++j) {
+      const double theta = CV_PI * (j + 0.5) / height;
+      const double sin_theta = sin( theta );
+      const double cos_theta = cos( theta );
+      const RowMoments& moments = row_moments[j];
+      const glm::dvec3 weighted_constant = moments[CONSTANT] * (sin_theta * pixel_solid_angle);
+      const glm::dvec3 weighted_cos_phi = moments[COS_PHI] * (sin_theta * pixel_solid_angle);
+      const glm::dvec3 weighted_sin_phi = moments[SIN_PHI] * (sin_theta * pixel_solid_angle);
+      const glm::dvec3 weighted_cos_2phi = moments[COS_2PHI] * (sin_theta * pixel_solid_angle);
+      const glm::dvec3 weighted_sin_2phi = moments[SIN_2PHI] * (sin_theta * pixel_solid_angle);
+      sums[0] += 0.282095 * weighted_constant;
+      sums[1] += 0.488603 * sin_theta * weighted_sin_phi;
+      sums[2] += -0.488603 * cos_theta * weighted_constant;
+      sums[3] += -0.488603 * sin_theta * weighted_cos_phi;
+      sums[4] += -0.546274 * sin_theta * sin_theta * weighted_sin_2phi;
+      sums[5] += -1.092548 * sin_theta * cos_theta * weighted_sin_phi;
+      sums[6] += 0.315392 * (3.0 * cos_theta * cos_theta - 1.0) * weighted_constant;
+      sums[7] += 1.092548 * sin_theta * cos_theta * weighted_cos_phi;
+      sums[8] += 0.546274 * sin_theta * sin_theta * weighted_cos_2phi;
+   }
+   for (int k = 0; k < CoefficientNum; ++k) radiance[k] = glm::vec3(sums[k]);
+}
+
+void SphericalHarmonics::convolveWithCosineLobe(Coefficients& irradiance, const Coefficients& radiance)
+// The cosine lobe scales each band by PI, 2PI/3 and PI/4.
+{
+   constexpr std::array<float, CoefficientNum> band_scales = {
+      1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+   };
+   for (int k = 0; k < CoefficientNum; ++k) irradiance[k] = radiance[k] * band_scales[k];
+}
+
+glm::vec3 SphericalHarmonics::evaluate(const Coefficients& coefficients, const glm::vec3& direction)
+// It is the same as getIrradianceFromSphericalHarmonics() in BasicPipeline.frag.
+{
+   const float x = direction.x;
+   const float y = direction.y;
+   const float z = direction.z;
+   return
+      coefficients[0] * 0.282095f +
+      coefficients[1] * (0.488603f * y) +
+      coefficients[2] * (0.488603f * z) +
+      coefficients[3] * (0.488603f * x) +
+      coefficients[4] * (1.092548f * x * y) +
+      coefficients[5] * (1.092548f * y * z) +
+      coefficients[6] * (0.315392f * (3.0f * z * z - 1.0f)) +
+      coefficients[7] * (1.092548f * x * z) +
+      coefficients[8] * (0.546274f * (x * x - y * y));
+}
\ No newline at end of file
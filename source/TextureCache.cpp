@@ -0,0 +1,134 @@
+#include "TextureCache.h"
+
+void TextureCacheGL::removeExpiredTextures()
+{
+   for (auto it = Textures.begin(); it != Textures.end();) {
+      if (it->second.expired()) it = Textures.erase( it );
+      else ++it;
+   }
+}
+
+int TextureCacheGL::getTextureNum()
+{
+   removeExpiredTextures();
+   return static_cast<int>(Textures.size());
+}
+
+GLuint TextureCacheGL::uploadTexture(const cv::Mat& texture)
+// It allocates the same storage as ObjectGL::addTexture(const cv::Mat&). The reflection in BasicPipeline.frag computes
+// the texture coordinates with atan(), whose derivatives jump at the seam, so more mip levels would draw the seam.
+{
+   const int width = texture.cols;
+   const int height = texture.rows;
+
+   GLuint texture_id = 0;
+   glCreateTextures( GL_TEXTURE_2D, 1, &texture_id );
+   glTextureStorage2D( texture_id, 1, GL_RGBA8, width, height );
+   glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+   glPixelStorei( GL_UNPACK_ROW_LENGTH, static_cast<GLint>(texture.step / texture.elemSize()) );
+   glTextureSubImage2D( texture_id, 0, 0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, texture.data );
+   glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+   glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+   glTextureParameteri( texture_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+   glTextureParameteri( texture_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_S, GL_REPEAT );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_T, GL_REPEAT );
+   glGenerateTextureMipmap( texture_id );
+   return texture_id;
+}
+
+GLuint TextureCacheGL::uploadCubemapTexture(const std::vector<cv::Mat>& levels)
+// Unlike the longitude-latitude texture, a cube map has no seam to draw, so it keeps the full mip chain.
+// The prefiltered levels in floats keep their precision in half floats, since the rough levels are smooth gradients.
+{
+   const int face_size = levels[0].cols;
+   const bool is_float = levels[0].type() == CV_32FC3;
+   const bool generates_mipmap = levels.size() == 1;
+   const auto level_num = generates_mipmap ?
+      static_cast<GLsizei>(std::floor( std::log2( face_size ) )) + 1 : static_cast<GLsizei>(levels.size());
+
+   GLuint texture_id = 0;
+   glCreateTextures( GL_TEXTURE_CUBE_MAP, 1, &texture_id );
+   glTextureStorage2D( texture_id, level_num, is_float ? GL_RGB16F : GL_RGBA8, face_size, face_size );
+   glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+   for (size_t level = 0; level < levels.size(); ++level) {
+      const cv::Mat& faces = levels[level];
+      glPixelStorei( GL_UNPACK_ROW_LENGTH, static_cast<GLint>(faces.step / faces.elemSize()) );
+      for (int face = 0; face < 6; ++face) {
+         glTextureSubImage3D(
+            texture_id, static_cast<GLint>(level), 0, 0, face, faces.cols, faces.cols, 1,
+            GL_BGR, is_float ? GL_FLOAT : GL_UNSIGNED_BYTE, faces.ptr( face * faces.cols )
+         );
+      }
+   }
+   glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+   glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+   glTextureParameteri( texture_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+   glTextureParameteri( texture_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+   glTextureParameteri( texture_id, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE );
+   if (generates_mipmap) glGenerateTextureMipmap( texture_id );
+   return texture_id;
+}
+
+TextureCacheGL::Handle TextureCacheGL::getTexture(const cv::Mat& texture)
+{
+   if (texture.type() != CV_8UC3) {
+      std::cerr << "Only a BGR image can be uploaded as a shared texture.\n";
+      return nullptr;
+   }
+   return getTexture( GL_TEXTURE_2D, { texture } );
+}
+
+TextureCacheGL::Handle TextureCacheGL::getCubemapTexture(const cv::Mat& faces)
+{
+   return getCubemapTexture( std::vector<cv::Mat>{ faces } );
+}
+
+TextureCacheGL::Handle TextureCacheGL::getCubemapTexture(const std::vector<cv::Mat>& levels)
+{
+   if (levels.empty() || (levels[0].type() != CV_8UC3 && levels[0].type() != CV_32FC3)) {
+      std::cerr << "Only a BGR image in bytes or floats can be uploaded as a shared cube map.\n";
+      return nullptr;
+   }
+   for (size_t level = 0; level < levels.size(); ++level) {
+      const int face_size = std::max( levels[0].cols >> level, 1 );
+      if (levels[level].type() != levels[0].type() || levels[level].cols != face_size ||
+          levels[level].rows != face_size * 6) {
+         std::cerr << "The cube map faces should be stacked into an image whose height is 6 times its width, "
+            "and each mip level should halve the faces.\n";
+         return nullptr;
+      }
+   }
+   return getTexture( GL_TEXTURE_CUBE_MAP, levels );
+}
+
+TextureCacheGL::Handle TextureCacheGL::getTexture(GLenum target, const std::vector<cv::Mat>& levels)
+{
+   const cv::Mat& texture = levels[0];
+   if (texture.empty()) {
+      std::cerr << "An empty image cannot be uploaded as a shared texture.\n";
+      return nullptr;
+   }
+
+   const TextureKey key{ target, texture.data, texture.cols, texture.rows, texture.type(), texture.step };
+   const auto it = Textures.find( key );
+   if (it != Textures.end()) {
+      if (Handle handle = it->second.lock()) return handle;
+   }
+
+   removeExpiredTextures();
+   const std::vector<cv::Mat> sources = levels;
+   Handle handle(
+      new GLuint(target == GL_TEXTURE_CUBE_MAP ? uploadCubemapTexture( levels ) : uploadTexture( texture )),
+      [sources](const GLuint* texture_id) {
+         glDeleteTextures( 1, texture_id );
+         delete texture_id;
+      }
+   );
+   Textures[key] = handle;
+   return handle;
+}
\ No newline at end of file